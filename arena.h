@@ -0,0 +1,73 @@
+#ifndef __ARENA_H__
+#define __ARENA_H__
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+
+// A bump allocator for objects that all die together, such as the nodes
+// of a parse tree. Memory is carved out of large blocks and only given
+// back when the Arena is cleared or destroyed, so nothing allocated here
+// is ever destructed: only trivially destructible objects belong in it.
+class Arena {
+	static const size_t blockSize = 1 << 16;
+	std::vector<char *> blocks;
+	char *next;
+	char *limit;
+
+	char *newBlock(size_t bytes) {
+		char *block = static_cast<char *>(std::malloc(bytes));
+		if (!block) throw std::bad_alloc();
+		blocks.push_back(block);
+		return block;
+	}
+	static char *alignUp(char *p, size_t align) {
+		return p + (-reinterpret_cast<uintptr_t>(p) & (align - 1));
+	}
+	Arena(const Arena&);
+	Arena& operator=(const Arena&);
+public:
+	Arena() : next(nullptr), limit(nullptr) {}
+	~Arena() {
+		clear();
+	}
+
+	// size bytes aligned to align, which must be a power of two
+	void *allocate(size_t size, size_t align = alignof(std::max_align_t)) {
+		char *p = next ? alignUp(next, align) : nullptr;
+		if (!p || p > limit || size > static_cast<size_t>(limit - p)) {
+			// A large request gets a block of its own, so that the
+			// rest of the current block is not wasted
+			if (size + align > blockSize / 4)
+				return alignUp(newBlock(size + align), align);
+			next = newBlock(blockSize);
+			limit = next + blockSize;
+			p = alignUp(next, align);
+		}
+		next = p + size;
+		return p;
+	}
+
+	// Room for n objects of type T
+	template <typename T>
+	T *allocateArray(size_t n) {
+		return static_cast<T *>(allocate(n * sizeof(T), alignof(T)));
+	}
+
+	// A copy of the length bytes at s
+	char *copy(const char *s, size_t length) {
+		char *p = allocateArray<char>(length);
+		memcpy(p, s, length);
+		return p;
+	}
+
+	// Free everything allocated so far
+	void clear() {
+		for (size_t i = 0; i < blocks.size(); ++i) std::free(blocks[i]);
+		blocks.clear();
+		next = limit = nullptr;
+	}
+};
+#endif
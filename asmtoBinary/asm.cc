@@ -6,6 +6,7 @@
 #include <iostream>
 #include <sstream>
 #include <cstdio>
+#include <cstring>
 #include <algorithm>    // std::find
 
 // Use only the needed aspects of each namespace
@@ -13,28 +14,29 @@ using std::string;
 using std::vector;
 using std::endl;
 using std::cerr;
-using std::cin;
-using std::getline;
 using ASM::Token;
 using ASM::Lexer;
 
-void printOutAllTokens(vector<Token*> &allTokens);
-void assembleTokens(vector<Token *> &tokens);
-void binaryGenerator(std::map<string, int> &st, vector< vector<Token *> > &correctInstr);
+// The Tokens of one line of input
+typedef vector<Token> TokenLine;
+
+void printOutAllTokens(TokenLine &allTokens);
+void assembleTokens(TokenLine &tokens);
+void binaryGenerator(std::map<string, int> &st, vector<TokenLine> &correctInstr);
 void outputWord(unsigned int operandValue);
 void outputSymbleTable(std::map<string, int> &st);
-void printOperands(vector<vector<Token *> > &correctInstr);
-void checkComponentPosition(vector<Token *> &tokens);
+void printOperands(vector<TokenLine> &correctInstr);
+void checkComponentPosition(TokenLine &tokens);
 bool checkLegalInstructionName(string instruName);
-void analyzeLine(vector< Token * > &tokens, vector< unsigned int > &intermediateResult, std::map< int, string > &indexLinesNeedLabel,
+void analyzeLine(TokenLine &tokens, vector< unsigned int > &intermediateResult, std::map< int, string > &indexLinesNeedLabel,
 	std::map<string, int> &st);
-unsigned int assemblyAddType(vector< Token * > &tokens, vector< Token * >::iterator it2);
-unsigned int assemblyMultType(vector< Token * > &tokens, vector< Token * >::iterator it2);
-unsigned int assemblyMfhiType(vector< Token * > &tokens, vector< Token * >::iterator it2);
-unsigned int assemblyLwType(vector< Token * > &tokens, vector< Token * >::iterator it2);
-unsigned int assemblyBeqType(vector< Token * > &tokens, vector< Token * >::iterator it2, bool & labelUsed, string &potentialLabel);
-unsigned int assemblyJrType(vector< Token * > &tokens, vector< Token * >::iterator it2);
-unsigned int assemblyWordType(vector< Token * > &tokens, vector< Token * >::iterator it2, bool &labelUsed, string &potentialLabel);
+unsigned int assemblyAddType(TokenLine &tokens, TokenLine::iterator it2);
+unsigned int assemblyMultType(TokenLine &tokens, TokenLine::iterator it2);
+unsigned int assemblyMfhiType(TokenLine &tokens, TokenLine::iterator it2);
+unsigned int assemblyLwType(TokenLine &tokens, TokenLine::iterator it2);
+unsigned int assemblyBeqType(TokenLine &tokens, TokenLine::iterator it2, bool & labelUsed, string &potentialLabel);
+unsigned int assemblyJrType(TokenLine &tokens, TokenLine::iterator it2);
+unsigned int assemblyWordType(TokenLine &tokens, TokenLine::iterator it2, bool &labelUsed, string &potentialLabel);
 
 namespace {
 	// legal string names for instructions
@@ -61,33 +63,47 @@ namespace {
 }
 
 int main(int argc, char* argv[]) {
-	// Nested vector representing lines of Tokens
-	// Needs to be used here to cleanup in the case
-	// of an exception
+	// The Tokens of every line, stored as one flat stream
+	Scan::TokenStream tokens;
 	// st store the symble table;
 	std::map<string, int>st;
-	// each line is a correct instruction
-	vector< vector<Token*> > correctInstr;
-	vector< vector<Token*> > tokLines;
 	std::map< int , string > indexLinesNeedLabel;
-	vector<Token*> allTokens;
 	vector< unsigned int > intermediateResult;
 	bool waitingForOp = true;
 	try {
 		// Create a MIPS recognizer to tokenize
 		// the input lines
 		Lexer lexer;
+		// Read the whole input into one buffer that the Tokens point into
+		string input;
+		char buf[65536];
+		size_t n;
+		while ((n = fread(buf, 1, sizeof buf, stdin)) > 0) {
+			input.append(buf, n);
+		}
 		// Tokenize each line of the input
-		string line;
-		while (getline(cin, line)) {
-			tokLines.push_back(lexer.scan(line));
+		const char *source = input.data();
+		const char *end = source + input.size();
+		uint32_t lineNo = 0;
+		for (const char *line = source; line != end; ++lineNo) {
+			const char *eol = static_cast<const char *>(memchr(line, '\n', end - line));
+			if (!eol) eol = end;
+			lexer.scan(source, line, eol, lineNo, tokens);
+			line = eol == end ? end : eol + 1;
 		}
 
-		vector<vector<Token*> >::iterator it;
-		for (it = tokLines.begin(); it != tokLines.end(); ++it) {
+		// Hand the Tokens of each line to analyzeLine; the vector of
+		// handles is reused from one line to the next
+		TokenLine lineTokens;
+		for (size_t i = 0; i != tokens.size();) {
+			lineTokens.clear();
+			uint32_t line = tokens.line(i);
+			for (; i != tokens.size() && tokens.line(i) == line; ++i) {
+				lineTokens.push_back(Token(tokens, source, i));
+			}
 			// scan each line
-			analyzeLine(*it, intermediateResult, indexLinesNeedLabel, st );
-			//checkComponentPosition(*it);
+			analyzeLine(lineTokens, intermediateResult, indexLinesNeedLabel, st );
+			//checkComponentPosition(lineTokens);
 		}
 		// after analyze every line, we got a intermediate result and a symbol table and set of instructions 
 		// that need to add address
@@ -128,26 +144,18 @@ int main(int argc, char* argv[]) {
 		// If an exception occurs print the message and end the program
 		cerr << msg << endl;
 	}
-	// Delete the Tokens that have been made
-	vector<vector<Token*> >::iterator it;
-	for (it = tokLines.begin(); it != tokLines.end(); ++it) {
-		vector<Token*>::iterator it2;
-		for (it2 = it->begin(); it2 != it->end(); ++it2) {
-			delete *it2;
-		}
-	}
 }
 
-void analyzeLine(vector< Token * > &tokens, vector< unsigned int > &intermediateResult, std::map< int , string > &indexLinesNeedLabel,
+void analyzeLine(TokenLine &tokens, vector< unsigned int > &intermediateResult, std::map< int , string > &indexLinesNeedLabel,
 	std::map<string, int> &st) {
-	vector< Token* >::iterator it2;
+	TokenLine::iterator it2;
 	// we must first deal with labels because they are the first couple items
 	// in each line
 	for (it2 = tokens.begin(); it2 != tokens.end(); it2++) {
-		if (((*it2)->toString()) != "LABEL") {
+		if ((it2->getKind()) != ASM::LABEL) {
 			break;
 		}
-		string lexeme = (*(*it2)).getLexeme();
+		string lexeme = it2->getLexeme();
 		string labelString = lexeme.substr(0, lexeme.size() - 1);
 		if (st.find(labelString) == st.end()) {
 			// the label hasnt been defined
@@ -168,26 +176,26 @@ void analyzeLine(vector< Token * > &tokens, vector< unsigned int > &intermediate
 	}
 	// if there is a instruction,
 	// we start to analyze instructions:
-	if (((*it2)->toString() == "ID" || (*it2)->toString() == "DOTWORD" )&&
-		checkLegalInstructionName((*it2)->getLexeme())) {
+	if ((it2->getKind() == ASM::ID || it2->getKind() == ASM::DOTWORD )&&
+		checkLegalInstructionName(it2->getLexeme())) {
 		// this is a legel instruction name
 		//we need to get parameters next
 
 		// 1. add, sub, slt, sltu
 		// add $1, $2, $3
-		if ((*it2)->getLexeme() == "add" ||
-			(*it2)->getLexeme() == "sub" ||
-			(*it2)->getLexeme() == "slt" ||
-			(*it2)->getLexeme() == "sltu"){
+		if (it2->getLexeme() == "add" ||
+			it2->getLexeme() == "sub" ||
+			it2->getLexeme() == "slt" ||
+			it2->getLexeme() == "sltu"){
 				unsigned int mipsCode = assemblyAddType(tokens, it2);
 				intermediateResult.push_back(mipsCode);
 		}
 		// 2. mult, multu, div, divu
 		// mult $4, $5
-		if ((*it2)->getLexeme() == "mult" ||
-			(*it2)->getLexeme() == "multu" ||
-			(*it2)->getLexeme() == "div" ||
-			(*it2)->getLexeme() == "divu") {
+		if (it2->getLexeme() == "mult" ||
+			it2->getLexeme() == "multu" ||
+			it2->getLexeme() == "div" ||
+			it2->getLexeme() == "divu") {
 				// correct number of COMMA, REGISTER, ID
 				unsigned int mipsCode = assemblyMultType(tokens, it2);
 				intermediateResult.push_back(mipsCode);
@@ -195,9 +203,9 @@ void analyzeLine(vector< Token * > &tokens, vector< unsigned int > &intermediate
 
 		// 3. mfhi, mflo, lis
 		// These opcodes have a single register operand, $d.
-		if ((*it2)->getLexeme() == "mfhi" ||
-			(*it2)->getLexeme() == "mflo" ||
-			(*it2)->getLexeme() == "lis") {
+		if (it2->getLexeme() == "mfhi" ||
+			it2->getLexeme() == "mflo" ||
+			it2->getLexeme() == "lis") {
 			// correct number of COMMA, REGISTER, ID
 			unsigned int mipsCode = assemblyMfhiType(tokens, it2);
 			intermediateResult.push_back(mipsCode);
@@ -205,8 +213,8 @@ void analyzeLine(vector< Token * > &tokens, vector< unsigned int > &intermediate
 
 		// 4. lw, sw
 		// opcode $t, i($s) 
-		if ((*it2)->getLexeme() == "lw" ||
-			(*it2)->getLexeme() == "sw") {
+		if (it2->getLexeme() == "lw" ||
+			it2->getLexeme() == "sw") {
 			// correct number of COMMA, REGISTER, ID
 			unsigned int mipsCode = assemblyLwType(tokens, it2);
 			intermediateResult.push_back(mipsCode);
@@ -214,8 +222,8 @@ void analyzeLine(vector< Token * > &tokens, vector< unsigned int > &intermediate
 
 		// 5. beq, bne
 		// opcode $t, i($s) 
-		if ((*it2)->getLexeme() == "beq" ||
-			(*it2)->getLexeme() == "bne") {
+		if (it2->getLexeme() == "beq" ||
+			it2->getLexeme() == "bne") {
 			// correct number of COMMA, REGISTER, ID
 			bool labelUsed = false;
 			string potentialLabel = "";
@@ -230,8 +238,8 @@ void analyzeLine(vector< Token * > &tokens, vector< unsigned int > &intermediate
 
 		// 6. jr, jalr
 		// opcode $t, i($s) 
-		if ((*it2)->getLexeme() == "jr" ||
-			(*it2)->getLexeme() == "jalr") {
+		if (it2->getLexeme() == "jr" ||
+			it2->getLexeme() == "jalr") {
 			// correct number of COMMA, REGISTER, ID
 			unsigned int mipsCode = assemblyJrType(tokens, it2);
 			intermediateResult.push_back(mipsCode);
@@ -239,7 +247,7 @@ void analyzeLine(vector< Token * > &tokens, vector< unsigned int > &intermediate
 
 		// 7. .word
 		// opcode $t, i($s) 
-		if ((*it2)->getLexeme() == ".word") {
+		if (it2->getLexeme() == ".word") {
 			// correct number of COMMA, REGISTER, ID
 			
 			bool labelUsed = false;
@@ -256,7 +264,7 @@ void analyzeLine(vector< Token * > &tokens, vector< unsigned int > &intermediate
 	else {
 		// throw errorMsg
 		string errorMsg = "ERROR: expected an instruction name, but ";
-		errorMsg = errorMsg + (*it2)->getLexeme();
+		errorMsg = errorMsg + it2->getLexeme();
 		errorMsg = errorMsg + " was found";
 		throw (errorMsg);
 	}
@@ -270,16 +278,16 @@ bool checkLegalInstructionName(string instruName) {
 		return false;
 }
 
-unsigned int assemblyAddType(vector< Token * > &tokens, vector< Token * >::iterator it2) {
+unsigned int assemblyAddType(TokenLine &tokens, TokenLine::iterator it2) {
 	// 1. add sub, slt, sltu
 	// add $1, $2, $3
 	if ((tokens.end() - it2) != 6) {
 		string errorMsg = "ERROR:wrong number of tokens after";
-		errorMsg = errorMsg + (*it2)->getLexeme();
+		errorMsg = errorMsg + it2->getLexeme();
 		throw (errorMsg);
 	}
 	unsigned int op = 0;
-	string instructionName = (*(it2))->getLexeme();
+	string instructionName = it2->getLexeme();
 	if (instructionName == "add") {
 		op = 32;
 	}
@@ -292,33 +300,33 @@ unsigned int assemblyAddType(vector< Token * > &tokens, vector< Token * >::itera
 	else if (instructionName == "sltu") {
 		op = 43;
 	}
-	if ((*(it2 + 1))->toString() == "REGISTER" &&
-		(*(it2 + 2))->toString() == "COMMA" &&
-		(*(it2 + 3))->toString() == "REGISTER" &&
-		(*(it2 + 4))->toString() == "COMMA" &&
-		(*(it2 + 5))->toString() == "REGISTER") {
-		unsigned int d = (*(it2 + 1))->toInt();
-		unsigned int s = (*(it2 + 3))->toInt();
-		unsigned int t = (*(it2 + 5))->toInt();
+	if ((it2 + 1)->getKind() == ASM::REGISTER &&
+		(it2 + 2)->getKind() == ASM::COMMA &&
+		(it2 + 3)->getKind() == ASM::REGISTER &&
+		(it2 + 4)->getKind() == ASM::COMMA &&
+		(it2 + 5)->getKind() == ASM::REGISTER) {
+		unsigned int d = (it2 + 1)->toInt();
+		unsigned int s = (it2 + 3)->toInt();
+		unsigned int t = (it2 + 5)->toInt();
 		unsigned int word = (0 << 26) | (s << 21) | (t << 16) | (d << 11) | op;
 		return word;
 	}
 	else {
 		string errorMsg = "ERROR: wrong type of tokens after";
-		errorMsg = errorMsg + (*it2)->getLexeme();
+		errorMsg = errorMsg + it2->getLexeme();
 		throw (errorMsg);
 	}
 }
 
-unsigned int assemblyMultType(vector< Token * > &tokens, vector< Token * >::iterator it2) {
+unsigned int assemblyMultType(TokenLine &tokens, TokenLine::iterator it2) {
 	// 2. mult $s, $t
 	if ((tokens.end() - it2) != 4) {
 		string errorMsg = "ERROR:wrong number of tokens after";
-		errorMsg = errorMsg + (*it2)->getLexeme();
+		errorMsg = errorMsg + it2->getLexeme();
 		throw (errorMsg);
 	}
 	unsigned int op=0;
-	string instructionName = (*(it2))->getLexeme();
+	string instructionName = it2->getLexeme();
 	if (instructionName == "mult") {
 		op = 24;
 	}
@@ -332,32 +340,32 @@ unsigned int assemblyMultType(vector< Token * > &tokens, vector< Token * >::iter
 		op = 27;
 	}
 
-	if ((*(it2 + 1))->toString() == "REGISTER" &&
-		(*(it2 + 2))->toString() == "COMMA" &&
-		(*(it2 + 3))->toString() == "REGISTER") {
-		unsigned int s = (*(it2 + 1))->toInt();
-		unsigned int t = (*(it2 + 3))->toInt();
+	if ((it2 + 1)->getKind() == ASM::REGISTER &&
+		(it2 + 2)->getKind() == ASM::COMMA &&
+		(it2 + 3)->getKind() == ASM::REGISTER) {
+		unsigned int s = (it2 + 1)->toInt();
+		unsigned int t = (it2 + 3)->toInt();
 		unsigned int word = (0 << 26) | (s << 21) | (t << 16)  | op;
 		return word;
 	}
 	else {
 		string errorMsg = "ERROR: wrong type of tokens after";
-		errorMsg = errorMsg + (*it2)->getLexeme();
+		errorMsg = errorMsg + it2->getLexeme();
 		throw (errorMsg);
 	}
 }
 
-unsigned int assemblyMfhiType(vector< Token * > &tokens, vector< Token * >::iterator it2) {
+unsigned int assemblyMfhiType(TokenLine &tokens, TokenLine::iterator it2) {
 	// 3. mfhi $d
 	//    mflo $d
 	//    lis $d
 	if ((tokens.end() - it2) != 2) {
 		string errorMsg = "ERROR:wrong number of tokens after";
-		errorMsg = errorMsg + (*it2)->getLexeme();
+		errorMsg = errorMsg + it2->getLexeme();
 		throw (errorMsg);
 	}
 	unsigned int op = 0;
-	string instructionName = (*(it2))->getLexeme();
+	string instructionName = it2->getLexeme();
 	if (instructionName == "mfhi") {
 		op = 16;
 	}
@@ -368,27 +376,27 @@ unsigned int assemblyMfhiType(vector< Token * > &tokens, vector< Token * >::iter
 		op = 20;
 	}
 
-	if ((*(it2 + 1))->toString() == "REGISTER") {
-		unsigned int d = (*(it2 + 1))->toInt();
+	if ((it2 + 1)->getKind() == ASM::REGISTER) {
+		unsigned int d = (it2 + 1)->toInt();
 		unsigned int word = (0 << 26) | (d << 11) | op;
 		return word;
 	}
 	else {
 		string errorMsg = "ERROR: wrong type of tokens after";
-		errorMsg = errorMsg + (*it2)->getLexeme();
+		errorMsg = errorMsg + it2->getLexeme();
 		throw (errorMsg);
 	}
 }
 
-unsigned int assemblyLwType(vector< Token * > &tokens, vector< Token * >::iterator it2) {
+unsigned int assemblyLwType(TokenLine &tokens, TokenLine::iterator it2) {
 	// opcode $t, i($s) 
 	if ((tokens.end() - it2) != 7) {
 		string errorMsg = "ERROR:wrong number of tokens after";
-		errorMsg = errorMsg + (*it2)->getLexeme();
+		errorMsg = errorMsg + it2->getLexeme();
 		throw (errorMsg);
 	}
 	unsigned int func = 0;
-	string instructionName = (*(it2))->getLexeme();
+	string instructionName = it2->getLexeme();
 	if (instructionName == "lw") {
 		// 100011
 		func = 35;
@@ -398,17 +406,17 @@ unsigned int assemblyLwType(vector< Token * > &tokens, vector< Token * >::iterat
 		func = 43;
 	}
 	
-	if ((*(it2 + 1))->toString() == "REGISTER"&&
-		(*(it2 + 2))->toString() == "COMMA"&&
-		((*(it2 + 3))->toString() == "INT" ||
-			(*(it2 + 3))->toString() == "HEXINT")&&
-		(*(it2 + 4))->toString() == "LPAREN"&&
-		(*(it2 + 5))->toString() == "REGISTER"&&
-		(*(it2 + 6))->toString() == "RPAREN") {
-		unsigned int t = (*(it2 + 1))->toInt();
-		int i = (*(it2 + 3))->toInt();
-		unsigned int s = (*(it2 + 5))->toInt();
-		if ((*(it2 + 3))->toString() == "INT") {
+	if ((it2 + 1)->getKind() == ASM::REGISTER&&
+		(it2 + 2)->getKind() == ASM::COMMA&&
+		((it2 + 3)->getKind() == ASM::INT ||
+			(it2 + 3)->getKind() == ASM::HEXINT)&&
+		(it2 + 4)->getKind() == ASM::LPAREN&&
+		(it2 + 5)->getKind() == ASM::REGISTER&&
+		(it2 + 6)->getKind() == ASM::RPAREN) {
+		unsigned int t = (it2 + 1)->toInt();
+		int i = (it2 + 3)->toInt();
+		unsigned int s = (it2 + 5)->toInt();
+		if ((it2 + 3)->getKind() == ASM::INT) {
 			if (i > 32767 ||
 				i < -32768) {
 				string errorMsg = "ERROR: The i value for ";
@@ -417,7 +425,7 @@ unsigned int assemblyLwType(vector< Token * > &tokens, vector< Token * >::iterat
 				throw (errorMsg);
 			}
 		}
-		if ((*(it2 + 3))->toString() == "HEXINT") {
+		if ((it2 + 3)->getKind() == ASM::HEXINT) {
 			int hignBitsI = (i >> 16) & 65535;
 			if (hignBitsI != 0) {
 				string errorMsg = "ERROR: The i value for ";
@@ -432,22 +440,22 @@ unsigned int assemblyLwType(vector< Token * > &tokens, vector< Token * >::iterat
 	}
 	else {
 		string errorMsg = "ERROR: wrong type of tokens after";
-		errorMsg = errorMsg + (*it2)->getLexeme();
+		errorMsg = errorMsg + it2->getLexeme();
 		throw (errorMsg);
 	}
 }
 
-unsigned int assemblyBeqType(vector< Token * > &tokens, vector< Token * >::iterator it2, bool & labelUsed, string &potentialLabel) {
+unsigned int assemblyBeqType(TokenLine &tokens, TokenLine::iterator it2, bool & labelUsed, string &potentialLabel) {
 	// beq $s, $t, i
 	// 
 	bool labelAsParam = false;
 	if ((tokens.end() - it2) != 6) {
 		string errorMsg = "ERROR:wrong number of tokens after";
-		errorMsg = errorMsg + (*it2)->getLexeme();
+		errorMsg = errorMsg + it2->getLexeme();
 		throw (errorMsg);
 	}
 	unsigned int func = 0;
-	string instructionName = (*(it2))->getLexeme();
+	string instructionName = it2->getLexeme();
 	if (instructionName == "beq") {
 		// 100011
 		func = 4;
@@ -458,18 +466,18 @@ unsigned int assemblyBeqType(vector< Token * > &tokens, vector< Token * >::itera
 	}
 
 
-	if ((*(it2 + 1))->toString() == "REGISTER" &&
-		(*(it2 + 2))->toString() == "COMMA" &&
-		(*(it2 + 3))->toString() == "REGISTER" &&
-		(*(it2 + 4))->toString() == "COMMA" &&
-		((*(it2 + 5))->toString() == "INT" ||
-		(*(it2 + 5))->toString() == "HEXINT" ||
-		(*(it2 + 5))->toString() == "ID")) {
-		unsigned int s = (*(it2 + 1))->toInt();
-		unsigned int t = (*(it2 + 3))->toInt();
+	if ((it2 + 1)->getKind() == ASM::REGISTER &&
+		(it2 + 2)->getKind() == ASM::COMMA &&
+		(it2 + 3)->getKind() == ASM::REGISTER &&
+		(it2 + 4)->getKind() == ASM::COMMA &&
+		((it2 + 5)->getKind() == ASM::INT ||
+		(it2 + 5)->getKind() == ASM::HEXINT ||
+		(it2 + 5)->getKind() == ASM::ID)) {
+		unsigned int s = (it2 + 1)->toInt();
+		unsigned int t = (it2 + 3)->toInt();
 		int i = 0;
-		if ((*(it2 + 5))->toString() == "INT" ) {
-			i = (*(it2 + 5))->toInt();
+		if ((it2 + 5)->getKind() == ASM::INT ) {
+			i = (it2 + 5)->toInt();
 			
 			if (i > 32767 || i < -32768) {
 				string errorMsg = "ERROR: The i value for ";
@@ -479,8 +487,8 @@ unsigned int assemblyBeqType(vector< Token * > &tokens, vector< Token * >::itera
 			}
 			i = i & 65535;
 		}
-		else if ((*(it2 + 5))->toString() == "HEXINT" ) {
-			i = (*(it2 + 5))->toInt();
+		else if ((it2 + 5)->getKind() == ASM::HEXINT ) {
+			i = (it2 + 5)->toInt();
 			unsigned int unsignedI = i;
 			int hignBitsOfI = (i >> 16) & 65535;
 			if (hignBitsOfI != 0) {
@@ -492,27 +500,27 @@ unsigned int assemblyBeqType(vector< Token * > &tokens, vector< Token * >::itera
 			i = i & 65535;
 		} else {
 			labelUsed = true;
-			potentialLabel = (*(it2 + 5))->getLexeme();
+			potentialLabel = (it2 + 5)->getLexeme();
 		}
 		unsigned int word = (func << 26) | (s << 21) | (t << 16) | i;
 		return word;
 	}
 	else {
 		string errorMsg = "ERROR: wrong type of tokens after";
-		errorMsg = errorMsg + (*it2)->getLexeme();
+		errorMsg = errorMsg + it2->getLexeme();
 		throw (errorMsg);
 	}
 }
 
-unsigned int assemblyJrType(vector< Token * > &tokens, vector< Token * >::iterator it2) {
+unsigned int assemblyJrType(TokenLine &tokens, TokenLine::iterator it2) {
 	// jr $s
 	if ((tokens.end() - it2) != 2) {
 		string errorMsg = "ERROR:wrong number of tokens after";
-		errorMsg = errorMsg + (*it2)->getLexeme();
+		errorMsg = errorMsg + it2->getLexeme();
 		throw (errorMsg);
 	}
 	unsigned int op = 0;
-	string instructionName = (*(it2))->getLexeme();
+	string instructionName = it2->getLexeme();
 	if (instructionName == "jr") {
 		// 1000
 		op = 8;
@@ -522,39 +530,39 @@ unsigned int assemblyJrType(vector< Token * > &tokens, vector< Token * >::iterat
 		op = 9;
 	}
 
-	if ((*(it2 + 1))->toString() == "REGISTER") {
-		unsigned int s = (*(it2 + 1))->toInt();
+	if ((it2 + 1)->getKind() == ASM::REGISTER) {
+		unsigned int s = (it2 + 1)->toInt();
 		unsigned int word = (s << 21) | op;
 		return word;
 	}
 	else {
 		string errorMsg = "ERROR: wrong type of tokens after";
-		errorMsg = errorMsg + (*it2)->getLexeme();
+		errorMsg = errorMsg + it2->getLexeme();
 		throw (errorMsg);
 	}
 }
 
-unsigned int assemblyWordType(vector< Token * > &tokens, vector< Token * >::iterator it2, bool &labelUsed, string &potentialLabel) {
+unsigned int assemblyWordType(TokenLine &tokens, TokenLine::iterator it2, bool &labelUsed, string &potentialLabel) {
 	// jr $s
 	if ((tokens.end() - it2) != 2) {
 		string errorMsg = "ERROR:wrong number of tokens after";
-		errorMsg = errorMsg + (*it2)->getLexeme();
+		errorMsg = errorMsg + it2->getLexeme();
 		throw (errorMsg);
 	}
 	unsigned int word = 0;
-	if ((*(it2 + 1))->toString() == "INT" || 
-		(*(it2 + 1))->toString() == "HEXINT") {
-		unsigned int word = (*(it2 + 1))->toInt();
+	if ((it2 + 1)->getKind() == ASM::INT || 
+		(it2 + 1)->getKind() == ASM::HEXINT) {
+		unsigned int word = (it2 + 1)->toInt();
 		return word;
 	}
-	else if((*(it2 + 1))->toString() == "ID"){
+	else if((it2 + 1)->getKind() == ASM::ID){
 		labelUsed = true;
-		potentialLabel = (*(it2 + 1))->getLexeme();
+		potentialLabel = (it2 + 1)->getLexeme();
 		return word;
 	}
 	else {
 		string errorMsg = "ERROR: wrong type of tokens after";
-		errorMsg = errorMsg + (*it2)->getLexeme();
+		errorMsg = errorMsg + it2->getLexeme();
 		throw (errorMsg);
 	}
 }
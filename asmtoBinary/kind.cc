@@ -1,23 +1,9 @@
 #include "kind.h"
-#include <sstream>
+#include "../intparse.h"
 using std::string;
-using std::istringstream;
 
 // Use the annonymous namespace to prevent external linking
 namespace {
-  // Template function to convert from a string to some Type
-  // Primarily used for string to integer conversions
-  template <typename T>
-  T fromString(const string& s, bool hex = false){
-    istringstream iss(s);
-    T n;
-    if(hex)
-      iss >> std::hex;
-    if(iss >> n)
-      return n;
-    else
-      throw string("ERROR: Type not convertible from string.");
-  }
   // Strings representing the Kind of Token for printing
   const string kindStrings[] ={
     "ID",           // ID
@@ -34,67 +20,72 @@ namespace {
   };
 }
 
-ASM::Token::Token(ASM::Kind kind, string lexeme)
-: kind(kind), lexeme(lexeme){}
+ASM::Token::Token(const Scan::TokenStream &stream, const char *source, size_t index)
+: stream(&stream), source(source), index(index){}
 
-// Cannot convert Tokens that do not represent numbers
-// to an Integer
+// Only INT, HEXINT and REGISTER Tokens can be converted to an
+// Integer; their values were range checked when they were scanned
 int ASM::Token::toInt() const{
-  throw "ERROR: attempt to convert non-integer token: " + lexeme;
+  Kind kind = getKind();
+  if(kind != INT && kind != HEXINT && kind != REGISTER)
+    throw "ERROR: attempt to convert non-integer token: " + getLexeme();
+  int64_t value = stream->value(index);
+  if(value == NOT_CONVERTIBLE)
+    throw string("ERROR: Type not convertible from string.");
+  if(value == OUT_OF_RANGE)
+    throw "ERROR: constant out of range: " + getLexeme();
+  return value;
 }
 
 string ASM::Token::toString() const{
-  return ::kindStrings[kind];
+  return ::kindStrings[getKind()];
 }
 
 string ASM::Token::getLexeme() const{
-  return lexeme;
+  return string(source + stream->offset(index), stream->length(index));
 }
 
 ASM::Kind ASM::Token::getKind() const{
-  return kind;
+  return static_cast<Kind>(stream->kind(index));
 }
 
-ASM::IntToken::IntToken(ASM::Kind kind, string lexeme)
-: Token(kind,lexeme){}
-
-// Ensure that the IntToken is a valid Integer for conversion
-// Arguably, we could do this check in the constructor
-int ASM::IntToken::toInt() const{
-  long long l = ::fromString<long long>(lexeme);
-  if('-' == lexeme[0]){
-    if(l < -2147483648LL)
-      throw "ERROR: constant out of range: "  + lexeme;
-  } else{
-    unsigned long long ul = static_cast<unsigned long long>(l);
-    if(ul > 4294967295LL)
-      throw "ERROR: constant out of range: " + lexeme;
+// Decode an integer literal and check that it is in range for its kind.
+// Anything an istringstream could not have read into a long long (INT)
+// or an unsigned long long (HEXINT, REGISTER) is not convertible.
+int64_t ASM::decodeValue(ASM::Kind kind, const char *begin, const char *end){
+  uint64_t ul;
+  switch(kind){
+    case INT:{
+      if('-' == *begin){
+        if(!Scan::decimalValue(begin + 1, end, uint64_t(INT64_MAX) + 1, ul))
+          return NOT_CONVERTIBLE;
+        if(ul > 2147483648ULL)
+          return OUT_OF_RANGE;
+        return -static_cast<int64_t>(ul);
+      }
+      if(!Scan::decimalValue(begin, end, INT64_MAX, ul))
+        return NOT_CONVERTIBLE;
+      if(ul > 4294967295ULL)
+        return OUT_OF_RANGE;
+      return ul;
+    }
+    case HEXINT:
+      // Skip the 0x
+      if(!Scan::hexValue(begin + 2, end, ul))
+        return NOT_CONVERTIBLE;
+      if(ul > 0xffffffffULL)
+        return OUT_OF_RANGE;
+      return ul;
+    case REGISTER:
+      // Skip the $
+      if(!Scan::decimalValue(begin + 1, end, UINT64_MAX, ul))
+        return NOT_CONVERTIBLE;
+      if(ul > 31)
+        return OUT_OF_RANGE;
+      return ul;
+    default:
+      return 0;
   }
-  return l;
-}
-
-ASM::HexIntToken::HexIntToken(ASM::Kind kind, string lexeme)
-: Token(kind,lexeme){}
-
-// Ensure that the HexIntToken is a valid Integer for conversion
-// Arguably, we could do this check in the constructor
-int ASM::HexIntToken::toInt() const{
-  unsigned long long ul = ::fromString<unsigned long long>(lexeme,true);
-  if(ul > 0xffffffffLL)
-      throw "ERROR: constant out of range: " + lexeme;
-  return ul;
-}
-
-ASM::RegisterToken::RegisterToken(Kind kind, string lexeme)
-: Token(kind,lexeme){}
-
-// Ensure that the RegisterToken is a valid integer for conversion
-// Arguably, we could do this check in the constructor
-int ASM::RegisterToken::toInt() const{
-  unsigned long long ul = ::fromString<unsigned long long>(lexeme.substr(1));
-  if(ul > 31)
-      throw "ERROR: constant out of range: " + lexeme;
-  return ul;
 }
 
 // Print the pertinent information to the ostream
@@ -106,18 +97,3 @@ std::ostream& ASM::operator<<(std::ostream& out, const ASM::Token& t){
     out << t.toInt();
   return out;
 }
-
-// Make a new Token depending on the Kind provided
-// Integral Kinds correspond to the appropriate Token type
-ASM::Token* ASM::Token::makeToken(ASM::Kind kind, string lexeme){
-  switch(kind){
-    case INT:
-      return new IntToken(kind,lexeme);
-    case HEXINT:
-      return new HexIntToken(kind,lexeme);
-    case REGISTER:
-      return new RegisterToken(kind,lexeme);
-    default:
-      return new Token(kind,lexeme);
-  }
-}
@@ -2,6 +2,8 @@
 #define __KIND_H__
 #include <string>
 #include <iostream>
+#include <cstdint>
+#include "../tokenstream.h"
 namespace ASM{
   // The different kinds of Tokens that are part of different MIPS instructions
   // Used for determining the correct Token to create in the MIPS recognizer
@@ -19,53 +21,39 @@ namespace ASM{
     ERR          // Bad/Invalid Token
   };
 
+  // Integer Tokens are decoded once, when they are scanned. A literal
+  // that fails its range check is not reported then; it is recorded with
+  // one of these values so that toInt reports it when (and only if) the
+  // value is used, just as when toInt did the conversion itself
+  const int64_t OUT_OF_RANGE = INT64_MAX;
+  const int64_t NOT_CONVERTIBLE = INT64_MIN;
+
+  // The value to store for a Token of the given kind whose lexeme
+  // is [begin, end)
+  int64_t decodeValue(Kind kind, const char *begin, const char *end);
+
   // A Token class representing the concrete functions we
   // might want to apply to a MIPS Token
+  // The Token itself lives in a Scan::TokenStream; this is a
+  // lightweight handle to one entry of it
 
   class Token{
   protected:
-    // The kind of the Token
-    Kind kind;
-    // The actual string representing the Token
-    std::string lexeme;
+    // The stream the Token lives in, the source buffer its lexeme
+    // points into, and its position in the stream
+    const Scan::TokenStream *stream;
+    const char *source;
+    size_t index;
   public:
-    // A Factory Method that allows us to make specific Tokens
-    // based upon the Kind
-    static Token* makeToken(Kind kind, std::string lexeme);
-    Token(Kind kind, std::string lexeme);
+    Token(const Scan::TokenStream &stream, const char *source, size_t index);
     // Convenience functions for operations we might like to
     // use on a Token
-    virtual int toInt() const;
+    int toInt() const;
     std::string toString() const;
     std::string getLexeme() const;
     Kind getKind() const;
   };
 
-  // Subclass the Token class to allow specialized implementations
-  // of the toInt method, since each type of token has different ranges
-  // of valid values.
-
-  // Token class for Integers
-  class IntToken : public Token{
-  public:
-    IntToken(Kind kind, std::string lexeme);
-    virtual int toInt() const;
-  };
-
-  // Token class for Hexidecimal Integers
-  class HexIntToken : public Token{
-  public:
-    HexIntToken(Kind kind, std::string lexeme);
-    virtual int toInt() const;
-  };
-
-  // Token class for Integers representing Registers
-  class RegisterToken : public Token{
-  public:
-    RegisterToken(Kind kind, std::string lexeme);
-    virtual int toInt() const;
-  };
-
   // Overload the output operator for Tokens
   std::ostream& operator<<(std::ostream& out, const Token& t);
 }
@@ -1,7 +1,8 @@
 #include "lexer.h"
 #include "kind.h"
+#include "../dfa.h"
+#include "../simdscan.h"
 using std::string;
-using std::vector;
 
 // Use the annonymous namespace to prevent external linking
 namespace {
@@ -30,111 +31,95 @@ namespace {
     ASM::DOTWORD,        // ST_DOTWORD
     ASM::WHITESPACE      // ST_WHITESPACE
   };
-  const string whitespace = "\t\n\r ";
-  const string letters = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
-  const string digits = "0123456789";
-  const string hexDigits = "0123456789ABCDEFabcdef";
-  const string oneToNine =  "123456789";
+  // Character sets used by the transition function
+  constexpr const char *whitespace = "\t\n\r ";
+  constexpr const char *letters = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+  constexpr const char *lettersAndDigits = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
+  constexpr const char *digits = "0123456789";
+  constexpr const char *hexDigits = "0123456789ABCDEFabcdef";
+  constexpr const char *oneToNine =  "123456789";
 
-}
+  // The transition function of the MIPS recognizer
+  constexpr Scan::DfaRule transitions[] = {
+    { ASM::ST_START,      whitespace,       ASM::ST_WHITESPACE },
+    { ASM::ST_WHITESPACE, whitespace,       ASM::ST_WHITESPACE },
+    { ASM::ST_START,      letters,          ASM::ST_ID         },
+    { ASM::ST_ID,         lettersAndDigits, ASM::ST_ID         },
+    { ASM::ST_START,      oneToNine,        ASM::ST_INT        },
+    { ASM::ST_INT,        digits,           ASM::ST_INT        },
+    { ASM::ST_START,      "-",              ASM::ST_MINUS      },
+    { ASM::ST_MINUS,      digits,           ASM::ST_INT        },
+    { ASM::ST_START,      ",",              ASM::ST_COMMA      },
+    { ASM::ST_START,      "(",              ASM::ST_LPAREN     },
+    { ASM::ST_START,      ")",              ASM::ST_RPAREN     },
+    { ASM::ST_START,      "$",              ASM::ST_DOLLAR     },
+    { ASM::ST_DOLLAR,     digits,           ASM::ST_REGISTER   },
+    { ASM::ST_REGISTER,   digits,           ASM::ST_REGISTER   },
+    { ASM::ST_START,      "0",              ASM::ST_ZERO       },
+    { ASM::ST_ZERO,       "x",              ASM::ST_ZEROX      },
+    { ASM::ST_ZERO,       digits,           ASM::ST_INT        },
+    { ASM::ST_ZEROX,      hexDigits,        ASM::ST_HEXINT     },
+    { ASM::ST_HEXINT,     hexDigits,        ASM::ST_HEXINT     },
+    { ASM::ST_ID,         ":",              ASM::ST_LABEL      },
+    { ASM::ST_START,      ";",              ASM::ST_COMMENT    },
+    { ASM::ST_START,      ".",              ASM::ST_DOT        },
+    { ASM::ST_DOT,        "w",              ASM::ST_DOTW       },
+    { ASM::ST_DOTW,       "o",              ASM::ST_DOTWO      },
+    { ASM::ST_DOTWO,      "r",              ASM::ST_DOTWOR     },
+    { ASM::ST_DOTWOR,     "d",              ASM::ST_DOTWORD    },
+    // A comment can only ever lead to the comment state
+    { ASM::ST_COMMENT,    nullptr,          ASM::ST_COMMENT    }
+  };
+
+  constexpr int numStates = ASM::ST_WHITESPACE + 1;
+  constexpr Scan::Dfa<numStates, Scan::countClasses(transitions)> dfa(transitions);
 
-ASM::Lexer::Lexer(){
-  // Set default transitions to the Error state
-  for(int i=0; i < maxStates; ++i){
-    for(int j=0; j < maxTrans; ++j){
-      delta[i][j] = ST_ERR;
+  // These states loop on themselves, so the rest of the run can
+  // be skipped in bulk; a comment runs to the end of the line
+  const char *skipRun(uint8_t state, const char *p, const char *end){
+    switch(state){
+      case ASM::ST_WHITESPACE:
+        return Scan::skipRun<Scan::WhitespaceCR>(p, end);
+      case ASM::ST_ID:
+        return Scan::skipRun<Scan::AlphaNum>(p, end);
+      case ASM::ST_INT:
+      case ASM::ST_REGISTER:
+        return Scan::skipRun<Scan::Digits>(p, end);
+      case ASM::ST_HEXINT:
+        return Scan::skipRun<Scan::HexDigits>(p, end);
+      case ASM::ST_COMMENT:
+        return end;
+      default:
+        return p;
     }
   }
-  // Change transitions as appropriate for the MIPS recognizer
-  setTrans( ST_START,      whitespace,     ST_WHITESPACE );
-  setTrans( ST_WHITESPACE, whitespace,     ST_WHITESPACE );
-  setTrans( ST_START,      letters,        ST_ID         );
-  setTrans( ST_ID,         letters+digits, ST_ID         );
-  setTrans( ST_START,      oneToNine,      ST_INT        );
-  setTrans( ST_INT,        digits,         ST_INT        );
-  setTrans( ST_START,      "-",            ST_MINUS      );
-  setTrans( ST_MINUS,      digits,         ST_INT        );
-  setTrans( ST_START,      ",",            ST_COMMA      );
-  setTrans( ST_START,      "(",            ST_LPAREN     );
-  setTrans( ST_START,      ")",            ST_RPAREN     );
-  setTrans( ST_START,      "$",            ST_DOLLAR     );
-  setTrans( ST_DOLLAR,     digits,         ST_REGISTER   );
-  setTrans( ST_REGISTER,   digits,         ST_REGISTER   );
-  setTrans( ST_START,      "0",            ST_ZERO       );
-  setTrans( ST_ZERO,       "x",            ST_ZEROX      );
-  setTrans( ST_ZERO,       digits,         ST_INT        );
-  setTrans( ST_ZEROX,      hexDigits,      ST_HEXINT     );
-  setTrans( ST_HEXINT,     hexDigits,      ST_HEXINT     );
-  setTrans( ST_ID,         ":",            ST_LABEL      );
-  setTrans( ST_START,      ";",            ST_COMMENT    );
-  setTrans( ST_START,      ".",            ST_DOT        );
-  setTrans( ST_DOT,        "w",            ST_DOTW       );
-  setTrans( ST_DOTW,       "o",            ST_DOTWO      );
-  setTrans( ST_DOTWO,      "r",            ST_DOTWOR     );
-  setTrans( ST_DOTWOR,     "d",            ST_DOTWORD    );
-
-  // A comment can only ever lead to the comment state
-  for(int j=0; j < maxTrans; ++j) delta[ST_COMMENT][j] = ST_COMMENT;
-}
-
-// Set the transitions from one state to another state based upon characters in the
-// given string
-void ASM::Lexer::setTrans(ASM::State from, const string& chars, ASM::State to){
-  for(string::const_iterator it = chars.begin(); it != chars.end(); ++it)
-    delta[from][static_cast<unsigned int>(*it)] = to;
 }
 
-// Scan a line of input (as a string) and return a vector
-// of Tokens representing the MIPS instruction in that line
-vector<ASM::Token*> ASM::Lexer::scan(const string& line){
-  // Return vector
-  vector<Token*> ret;
-  if(line.size() == 0) return ret;
-  // Always begin at the start state
-  State currState = ST_START;
-  // startIter represents the beginning of the next Token
-  // that is to be recognized. Initially, this is the beginning
-  // of the line.
-  // Use a const_iterator since we cannot change the input line
-  string::const_iterator startIter = line.begin();
-  // Loop over the the line
-  for(string::const_iterator it = line.begin();;){
-    // Assume the next state is the error state
-    State nextState = ST_ERR;
-    // If we aren't done then get the transition from the current
-    // state to the next state based upon the current character of
-    //input
-    if(it != line.end())
-      nextState = delta[currState][static_cast<unsigned int>(*it)];
-    // If there is no valid transition then we have reach then end of a
-    // Token and can add a new Token to the return vector
-    if(ST_ERR == nextState){
-      // Get the kind corresponding to the current state
-      Kind currKind = stateKinds[currState];
-      // If we are in an Error state then we have reached an invalid
-      // Token - so we throw and error and delete the Tokens parsed
-      // thus far
-      if(ERR == currKind){
-        vector<Token*>::iterator vit;
-        for(vit = ret.begin(); vit != ret.end(); ++vit)
-          delete *vit;
-        throw "ERROR in lexing after reading " + string(line.begin(),it);
-      }
-      // If we are not in Whitespace then we push back a new token
-      // based upon the kind of the State we end in
-      // Whitespace is ignored for practical purposes
-      if(WHITESPACE != currKind)
-        ret.push_back(Token::makeToken(currKind,string(startIter,it)));
-      // Start of next Token begins here
-      startIter = it;
-      // Revert to start state to begin recognizing next token
-      currState = ST_START;
-      if(it == line.end()) break;
-    } else {
-      // Otherwise we proceed to the next state and increment the iterator
-      currState = nextState;
-      ++it;
+// Scan a line of input and append the Tokens representing the
+// MIPS instruction in that line to tokens
+void ASM::Lexer::scan(const char *source, const char *begin, const char *end,
+                      uint32_t line, Scan::TokenStream &tokens){
+  // Recognize one Token at a time, each starting at the start state
+  for(const char *startIter = begin; startIter != end;){
+    uint8_t currState = ST_START;
+    // it is where the longest match starting at startIter ends
+    const char *it = dfa.munch(startIter, end, currState, skipRun);
+    // Get the kind corresponding to the state the match ended in
+    Kind currKind = stateKinds[currState];
+    // If we are in an Error state then we have reached an invalid
+    // Token - so we throw and error
+    if(ERR == currKind)
+      throw "ERROR in lexing after reading " + string(begin,it);
+    // If we are not in Whitespace then we push back a new token
+    // based upon the kind of the State we end in
+    // Whitespace is ignored for practical purposes
+    if(WHITESPACE != currKind){
+      int64_t value = 0;
+      if(INT == currKind || HEXINT == currKind || REGISTER == currKind)
+        value = decodeValue(currKind, startIter, it);
+      tokens.push(currKind, startIter - source, it - startIter, value, line);
     }
+    // Start of next Token begins here
+    startIter = it;
   }
-  return ret;
 }
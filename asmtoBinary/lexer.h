@@ -1,7 +1,7 @@
 #ifndef __LEXER_H__
 #define __LEXER_H__
-#include <string>
-#include <vector>
+#include <cstdint>
+#include "../tokenstream.h"
 
 namespace ASM{
   // The different states the the MIPS recognizer uses
@@ -31,24 +31,14 @@ namespace ASM{
     ST_DOTWORD,
     ST_WHITESPACE
   };
-  // Forward declare the Token class to reduce compilation dependencies
-  class Token;
-
-  // Class representing a MIPS recognizer
+  // Class representing a MIPS recognizer, an instance of the
+  // shared DFA engine whose table is built at compile time
   class Lexer {
-    // At most 21 states and 256 transitions (max number of characters in ASCII)
-    static const int maxStates = 21;
-    static const int maxTrans = 256;
-    // Transition function
-    State delta[maxStates][maxTrans];
-    // Private method to set the transitions based upon characters in the
-    // given string
-    void setTrans(State from, const std::string& chars, State to);
   public:
-    Lexer();
-    // Output a vector of Tokens representing the Tokens present in the
-    // given line
-    std::vector<Token*> scan(const std::string& line);
+    // Append the Tokens present in the line [begin, end) of the
+    // buffer source to tokens, tagged with the given line index
+    void scan(const char *source, const char *begin, const char *end,
+              uint32_t line, Scan::TokenStream &tokens);
   };
 }
 
@@ -0,0 +1,102 @@
+#ifndef __DFA_H__
+#define __DFA_H__
+#include <cstddef>
+#include <cstdint>
+
+// The maximal-munch DFA engine shared by the WLP4 and MIPS lexers.
+// A lexer describes its transition function as a list of rules and the
+// table is built from them at compile time, so constructing a lexer
+// costs nothing at run time.
+namespace Scan {
+  // On any character of chars, go from state from to state to.
+  // A null chars matches every character. Later rules override
+  // earlier ones, as repeated setTrans calls used to.
+  struct DfaRule {
+    uint8_t from;
+    const char *chars;
+    uint8_t to;
+  };
+
+  // State 0 is always the error state; every transition not named by
+  // a rule leads there
+  const uint8_t DFA_ERR = 0;
+
+  // Bit r of the result is set when rule r matches c. Two characters
+  // with the same signature are treated alike by every rule, so they
+  // can share a column of the transition table.
+  template <size_t N>
+  constexpr uint64_t signature(const DfaRule (&rules)[N], unsigned char c){
+    uint64_t sig = 0;
+    for(size_t r = 0; r < N; ++r){
+      bool match = rules[r].chars == nullptr;
+      for(const char *p = rules[r].chars; p && *p && !match; ++p)
+        match = static_cast<unsigned char>(*p) == c;
+      if(match) sig |= uint64_t(1) << r;
+    }
+    return sig;
+  }
+
+  // Number the character equivalence classes of rules; class 0 is the
+  // characters no rule mentions. Returns the number of classes.
+  template <size_t N>
+  constexpr int classify(const DfaRule (&rules)[N], uint8_t (&charClass)[256]){
+    static_assert(N <= 64, "too many DFA rules for a 64-bit signature");
+    uint64_t classSig[256] = {};
+    int numClasses = 1;
+    for(int c = 0; c < 256; ++c){
+      uint64_t sig = signature(rules, c);
+      int k = 0;
+      while(k < numClasses && classSig[k] != sig) ++k;
+      if(k == numClasses) classSig[numClasses++] = sig;
+      charClass[c] = k;
+    }
+    return numClasses;
+  }
+
+  template <size_t N>
+  constexpr int countClasses(const DfaRule (&rules)[N]){
+    uint8_t charClass[256] = {};
+    return classify(rules, charClass);
+  }
+
+  // A DFA over NumStates states whose 256 input columns are compressed
+  // into NumClasses character classes (see countClasses)
+  template <int NumStates, int NumClasses>
+  class Dfa {
+    uint8_t charClass[256];
+    uint8_t delta[NumStates][NumClasses];
+  public:
+    template <size_t N>
+    constexpr explicit Dfa(const DfaRule (&rules)[N]) : charClass{}, delta{}{
+      classify(rules, charClass);
+      for(int c = 0; c < 256; ++c){
+        uint64_t sig = signature(rules, c);
+        for(size_t r = 0; r < N; ++r){
+          if(sig >> r & 1)
+            delta[rules[r].from][charClass[c]] = rules[r].to;
+        }
+      }
+    }
+
+    uint8_t next(uint8_t state, unsigned char c) const{
+      return delta[state][charClass[c]];
+    }
+
+    // Follow transitions from state over [p, end) until the next one
+    // would lead to the error state or the input runs out. state is left
+    // holding the last state reached and the position where the match
+    // stopped is returned. After every transition skip(state, p, end) may
+    // advance p over characters on which state loops to itself.
+    template <typename Skip>
+    const char *munch(const char *p, const char *end, uint8_t &state, Skip skip) const{
+      while(p != end){
+        uint8_t nextState = next(state, *p);
+        if(nextState == DFA_ERR) break;
+        state = nextState;
+        p = skip(state, p + 1, end);
+      }
+      return p;
+    }
+  };
+}
+#endif
@@ -0,0 +1,37 @@
+#ifndef __INTPARSE_H__
+#define __INTPARSE_H__
+#include <cstdint>
+
+// Integer literal decoding shared by the WLP4 and MIPS lexers. The
+// lexers have already checked the shape of a literal (its digits, sign,
+// prefix), so all that is left is to accumulate its value and notice
+// overflow; nothing is allocated, unlike extracting from an istringstream.
+namespace Scan {
+  // Decode the decimal digits in [p, end) into value. Returns false,
+  // leaving value unspecified, if the number is greater than max.
+  inline bool decimalValue(const char *p, const char *end, uint64_t max, uint64_t &value){
+    uint64_t v = 0;
+    for(; p != end; ++p){
+      unsigned digit = *p - '0';
+      if(v > (max - digit) / 10) return false;
+      v = v * 10 + digit;
+    }
+    value = v;
+    return true;
+  }
+
+  // Decode the hex digits in [p, end) into value. Returns false if the
+  // number does not fit in 64 bits.
+  inline bool hexValue(const char *p, const char *end, uint64_t &value){
+    uint64_t v = 0;
+    for(; p != end; ++p){
+      unsigned c = static_cast<unsigned char>(*p);
+      unsigned digit = c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10;
+      if(v >> 60) return false;
+      v = v << 4 | digit;
+    }
+    value = v;
+    return true;
+  }
+}
+#endif
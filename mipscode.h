@@ -0,0 +1,292 @@
+#ifndef __MIPSCODE_H__
+#define __MIPSCODE_H__
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// The MIPS program wlp4gen generates, held as a stream of fixed-size
+// instructions rather than lines of assembly text. It can be written out
+// either as the text the assembler reads or, with its labels resolved
+// in process, as a MERL object module ready for the linker.
+namespace MIPS {
+	enum Opcode : uint8_t {
+		ADD, SUB, SLT, SLTU,
+		MULT, MULTU, DIV, DIVU,
+		MFHI, MFLO, LIS,
+		LW, SW,
+		BEQ, BNE,
+		JR, JALR,
+		WORD,
+		// Pseudo-instructions, which take no space in the binary: the
+		// definition of a label, an .import and a comment line
+		LABEL, IMPORT, COMMENT
+	};
+
+	// One instruction. Registers a field does not use are 0. For lw and
+	// sw rt is the register loaded or stored and rs the base register.
+	struct Instr {
+		Opcode op;
+		uint8_t rd, rs, rt;
+		// imm is the label id when set: the target of beq, bne or .word
+		bool label;
+		// The immediate of lw, sw, beq, bne and .word; the label that
+		// LABEL defines or IMPORT imports; for COMMENT the offset of its
+		// text in Program::notes
+		int32_t imm;
+	};
+
+	// A program under construction. Labels are numbered as they are
+	// created and may be referred to before they are defined.
+	//
+	// A program can also be built in parts that are appended to it one
+	// after another. A part numbers its own labels from firstLabel on,
+	// which must be where the program's labels have got to when the part
+	// is appended; it can refer to the program's labels below that.
+	class Program {
+		int firstLabel;
+		std::vector<Instr> code;
+		std::vector<std::string> labelNames;
+		// The text of every comment, each ended by a NUL
+		std::string notes;
+
+		void emit(Opcode op, int rd, int rs, int rt, int32_t imm = 0, bool label = false) {
+			Instr instr = { op, static_cast<uint8_t>(rd), static_cast<uint8_t>(rs), static_cast<uint8_t>(rt), label, imm };
+			code.push_back(instr);
+		}
+
+		static void appendWord(std::string &out, uint32_t word) {
+			out += static_cast<char>(word >> 24);
+			out += static_cast<char>(word >> 16);
+			out += static_cast<char>(word >> 8);
+			out += static_cast<char>(word);
+		}
+		static void appendRegister(std::string &out, int r) {
+			out += '$';
+			out += std::to_string(r);
+		}
+
+	public:
+		explicit Program(int firstLabel = 0) : firstLabel(firstLabel) {}
+
+		int newLabel(const std::string &name) {
+			labelNames.push_back(name);
+			return firstLabel + labelNames.size() - 1;
+		}
+		// The id the next label will get
+		int labelCount() const {
+			return firstLabel + labelNames.size();
+		}
+
+		// Adds part, whose firstLabel must be labelCount(), to the end
+		void append(const Program &part) {
+			size_t notesBase = notes.size();
+			labelNames.insert(labelNames.end(), part.labelNames.begin(), part.labelNames.end());
+			notes += part.notes;
+			size_t start = code.size();
+			code.insert(code.end(), part.code.begin(), part.code.end());
+			for (size_t i = start; i < code.size(); i++) {
+				if (code[i].op == COMMENT) code[i].imm += notesBase;
+			}
+		}
+
+		void add(int d, int s, int t) { emit(ADD, d, s, t); }
+		void sub(int d, int s, int t) { emit(SUB, d, s, t); }
+		void slt(int d, int s, int t) { emit(SLT, d, s, t); }
+		void sltu(int d, int s, int t) { emit(SLTU, d, s, t); }
+		void mult(int s, int t) { emit(MULT, 0, s, t); }
+		void multu(int s, int t) { emit(MULTU, 0, s, t); }
+		void div(int s, int t) { emit(DIV, 0, s, t); }
+		void divu(int s, int t) { emit(DIVU, 0, s, t); }
+		void mfhi(int d) { emit(MFHI, d, 0, 0); }
+		void mflo(int d) { emit(MFLO, d, 0, 0); }
+		void lis(int d) { emit(LIS, d, 0, 0); }
+		// lw $t, i($s) and sw $t, i($s)
+		void lw(int t, int32_t i, int s) { emit(LW, 0, s, t, i); }
+		void sw(int t, int32_t i, int s) { emit(SW, 0, s, t, i); }
+		void beq(int s, int t, int32_t i) { emit(BEQ, 0, s, t, i); }
+		void bne(int s, int t, int32_t i) { emit(BNE, 0, s, t, i); }
+		void beqLabel(int s, int t, int label) { emit(BEQ, 0, s, t, label, true); }
+		void jr(int s) { emit(JR, 0, s, 0); }
+		void jalr(int s) { emit(JALR, 0, s, 0); }
+		void word(int32_t i) { emit(WORD, 0, 0, 0, i); }
+		void wordLabel(int label) { emit(WORD, 0, 0, 0, label, true); }
+		void label(int label) { emit(LABEL, 0, 0, 0, label); }
+		void import(int label) { emit(IMPORT, 0, 0, 0, label); }
+		// A comment line, written as ";; " and text
+		void comment(const std::string &text) {
+			emit(COMMENT, 0, 0, 0, notes.size());
+			notes.append(text.c_str(), text.size() + 1);
+		}
+
+		// The program as assembly text, one line per instruction. The
+		// writers are for a whole program, whose firstLabel is 0.
+		void writeAssembly(std::ostream &out) const {
+			std::string text;
+			for (size_t i = 0; i < code.size(); i++) {
+				const Instr &instr = code[i];
+				switch (instr.op) {
+				case ADD: case SUB: case SLT: case SLTU:
+					text += instr.op == ADD ? "add " : instr.op == SUB ? "sub " : instr.op == SLT ? "slt " : "sltu ";
+					appendRegister(text, instr.rd);
+					text += ", ";
+					appendRegister(text, instr.rs);
+					text += ", ";
+					appendRegister(text, instr.rt);
+					break;
+				case MULT: case MULTU: case DIV: case DIVU:
+					text += instr.op == MULT ? "mult " : instr.op == MULTU ? "multu " : instr.op == DIV ? "div " : "divu ";
+					appendRegister(text, instr.rs);
+					text += ", ";
+					appendRegister(text, instr.rt);
+					break;
+				case MFHI: case MFLO: case LIS:
+					text += instr.op == MFHI ? "mfhi " : instr.op == MFLO ? "mflo " : "lis ";
+					appendRegister(text, instr.rd);
+					break;
+				case LW: case SW:
+					text += instr.op == LW ? "lw " : "sw ";
+					appendRegister(text, instr.rt);
+					text += ", ";
+					text += std::to_string(instr.imm);
+					text += '(';
+					appendRegister(text, instr.rs);
+					text += ')';
+					break;
+				case BEQ: case BNE:
+					text += instr.op == BEQ ? "beq " : "bne ";
+					appendRegister(text, instr.rs);
+					text += ", ";
+					appendRegister(text, instr.rt);
+					text += ", ";
+					text += instr.label ? labelNames[instr.imm] : std::to_string(instr.imm);
+					break;
+				case JR: case JALR:
+					text += instr.op == JR ? "jr " : "jalr ";
+					appendRegister(text, instr.rs);
+					break;
+				case WORD:
+					text += ".word ";
+					text += instr.label ? labelNames[instr.imm] : std::to_string(instr.imm);
+					break;
+				case LABEL:
+					text += labelNames[instr.imm];
+					text += ':';
+					break;
+				case IMPORT:
+					text += ".import ";
+					text += labelNames[instr.imm];
+					break;
+				case COMMENT:
+					text += ";; ";
+					text += notes.c_str() + instr.imm;
+					break;
+				}
+				text += '\n';
+			}
+			out.write(text.data(), text.size());
+		}
+
+		// The program as a MERL module: the header word beq $0, $0, 2,
+		// the end of the module and the end of the code, then the code
+		// assembled to run at address 12, then the footer. The footer has
+		// a relocation entry (1, address) for every .word of a label
+		// defined here, and an external symbol reference (0x11, address,
+		// length, one word per character) for every .word of an imported
+		// label, whose word is left 0 for the linker to fill in.
+		void writeMerl(std::ostream &out) const {
+			const uint32_t origin = 12;
+			const uint32_t undefined = 1, imported = 2;
+			// The address of each label, or one of the two markers
+			std::vector<uint32_t> address(labelNames.size(), undefined);
+			uint32_t pc = origin;
+			for (size_t i = 0; i < code.size(); i++) {
+				if (code[i].op == LABEL) {
+					address[code[i].imm] = pc;
+				}
+				else if (code[i].op == IMPORT) {
+					address[code[i].imm] = imported;
+				}
+				else if (code[i].op != COMMENT) {
+					pc += 4;
+				}
+			}
+			std::string body, footer;
+			pc = origin;
+			for (size_t i = 0; i < code.size(); i++) {
+				const Instr &instr = code[i];
+				uint32_t word = 0;
+				if (instr.label && address[instr.imm] == undefined) {
+					throw std::string("ERROR: label {" + labelNames[instr.imm] + "} not found");
+				}
+				switch (instr.op) {
+				case ADD: case SUB: case SLT: case SLTU: {
+					const uint32_t funct[] = { 0x20, 0x22, 0x2a, 0x2b };
+					word = instr.rs << 21 | instr.rt << 16 | instr.rd << 11 | funct[instr.op - ADD];
+					break;
+				}
+				case MULT: case MULTU: case DIV: case DIVU:
+					word = instr.rs << 21 | instr.rt << 16 | (0x18 + (instr.op - MULT));
+					break;
+				case MFHI: case MFLO: case LIS: {
+					const uint32_t funct[] = { 0x10, 0x12, 0x14 };
+					word = instr.rd << 11 | funct[instr.op - MFHI];
+					break;
+				}
+				case LW: case SW:
+					word = (instr.op == LW ? 0x23u : 0x2bu) << 26 | instr.rs << 21 | instr.rt << 16 | (instr.imm & 0xffff);
+					break;
+				case BEQ: case BNE: {
+					int32_t offset = instr.imm;
+					if (instr.label) {
+						if (address[instr.imm] == imported) {
+							throw std::string("ERROR: branch to imported label {" + labelNames[instr.imm] + "}");
+						}
+						offset = (static_cast<int32_t>(address[instr.imm]) - static_cast<int32_t>(pc) - 4) / 4;
+						if (offset > 32767 || offset < -32768) {
+							throw std::string("ERROR: label value is out of range");
+						}
+					}
+					word = (instr.op == BEQ ? 0x04u : 0x05u) << 26 | instr.rs << 21 | instr.rt << 16 | (offset & 0xffff);
+					break;
+				}
+				case JR: case JALR:
+					word = instr.rs << 21 | (instr.op == JR ? 0x08 : 0x09);
+					break;
+				case WORD:
+					if (!instr.label) {
+						word = instr.imm;
+					}
+					else if (address[instr.imm] == imported) {
+						const std::string &name = labelNames[instr.imm];
+						appendWord(footer, 0x11);
+						appendWord(footer, pc);
+						appendWord(footer, name.size());
+						for (size_t c = 0; c < name.size(); c++) {
+							appendWord(footer, static_cast<unsigned char>(name[c]));
+						}
+					}
+					else {
+						word = address[instr.imm];
+						appendWord(footer, 0x01);
+						appendWord(footer, pc);
+					}
+					break;
+				default:
+					continue;
+				}
+				appendWord(body, word);
+				pc += 4;
+			}
+			std::string header;
+			appendWord(header, 0x10000002);
+			appendWord(header, origin + body.size() + footer.size());
+			appendWord(header, origin + body.size());
+			out.write(header.data(), header.size());
+			out.write(body.data(), body.size());
+			out.write(footer.data(), footer.size());
+		}
+	};
+}
+#endif
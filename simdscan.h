@@ -0,0 +1,94 @@
+#ifndef __SIMDSCAN_H__
+#define __SIMDSCAN_H__
+#include <cstddef>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Vectorized helpers shared by the WLP4 and MIPS lexers.
+// Whitespace, identifier and number runs are a single DFA state looping
+// on itself, so instead of taking one transition per byte a lexer can
+// jump straight to the end of the run and let the DFA handle only the
+// byte that ends it. Each character set below can be tested one byte at
+// a time or 16 (SSE2) / 32 (AVX2) bytes at a time.
+namespace Scan {
+#if defined(__SSE2__)
+  // Overloads so that the character sets can be written once for
+  // both vector widths
+  inline __m128i splat(__m128i, char c) { return _mm_set1_epi8(c); }
+  inline __m128i either(__m128i a, __m128i b) { return _mm_or_si128(a, b); }
+  inline __m128i equal(__m128i a, char c) { return _mm_cmpeq_epi8(a, _mm_set1_epi8(c)); }
+  // Bytes of v in [lo, hi], computed as (v - lo) <= (hi - lo) unsigned
+  inline __m128i inRange(__m128i v, char lo, char hi){
+    __m128i t = _mm_sub_epi8(v, _mm_set1_epi8(lo));
+    return _mm_cmpeq_epi8(_mm_min_epu8(t, _mm_set1_epi8(hi - lo)), t);
+  }
+  inline unsigned mask(__m128i v) { return _mm_movemask_epi8(v); }
+#endif
+#if defined(__AVX2__)
+  inline __m256i splat(__m256i, char c) { return _mm256_set1_epi8(c); }
+  inline __m256i either(__m256i a, __m256i b) { return _mm256_or_si256(a, b); }
+  inline __m256i equal(__m256i a, char c) { return _mm256_cmpeq_epi8(a, _mm256_set1_epi8(c)); }
+  inline __m256i inRange(__m256i v, char lo, char hi){
+    __m256i t = _mm256_sub_epi8(v, _mm256_set1_epi8(lo));
+    return _mm256_cmpeq_epi8(_mm256_min_epu8(t, _mm256_set1_epi8(hi - lo)), t);
+  }
+  inline unsigned mask(__m256i v) { return _mm256_movemask_epi8(v); }
+#endif
+  inline bool inRange(unsigned char c, char lo, char hi){
+    return static_cast<unsigned char>(c - lo) <= static_cast<unsigned char>(hi - lo);
+  }
+
+  // Space, tab and newline (WLP4 whitespace)
+  struct Whitespace {
+    static bool test(unsigned char c){ return c == ' ' || c == '\t' || c == '\n'; }
+    template <typename V> static V test(V v){ return either(either(equal(v, ' '), equal(v, '\t')), equal(v, '\n')); }
+  };
+  // Whitespace plus carriage return (MIPS whitespace)
+  struct WhitespaceCR {
+    static bool test(unsigned char c){ return Whitespace::test(c) || c == '\r'; }
+    template <typename V> static V test(V v){ return either(Whitespace::test(v), equal(v, '\r')); }
+  };
+  // 0-9
+  struct Digits {
+    static bool test(unsigned char c){ return inRange(c, '0', '9'); }
+    template <typename V> static V test(V v){ return inRange(v, '0', '9'); }
+  };
+  // 0-9, a-f and A-F; setting bit 5 folds upper case onto lower case
+  struct HexDigits {
+    static bool test(unsigned char c){ return inRange(c, '0', '9') || inRange(c | 0x20, 'a', 'f'); }
+    template <typename V> static V test(V v){ return either(inRange(v, '0', '9'), inRange(either(v, splat(v, 0x20)), 'a', 'f')); }
+  };
+  // Letters and digits
+  struct AlphaNum {
+    static bool test(unsigned char c){ return inRange(c, '0', '9') || inRange(c | 0x20, 'a', 'z'); }
+    template <typename V> static V test(V v){ return either(inRange(v, '0', '9'), inRange(either(v, splat(v, 0x20)), 'a', 'z')); }
+  };
+
+  // Return the first position in [p, end) whose character is not in Set.
+  // Vector loads never reach past end, so this is safe on mapped files.
+  template <typename Set>
+  const char *skipRun(const char *p, const char *end){
+#if defined(__AVX2__)
+    while(end - p >= 32){
+      __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+      unsigned m = ~mask(Set::test(v));
+      if(m) return p + __builtin_ctz(m);
+      p += 32;
+    }
+#endif
+#if defined(__SSE2__)
+    while(end - p >= 16){
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+      unsigned m = ~mask(Set::test(v)) & 0xffff;
+      if(m) return p + __builtin_ctz(m);
+      p += 16;
+    }
+#endif
+    while(p != end && Set::test(static_cast<unsigned char>(*p))) ++p;
+    return p;
+  }
+}
+#endif
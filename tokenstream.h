@@ -0,0 +1,98 @@
+#ifndef __TOKENSTREAM_H__
+#define __TOKENSTREAM_H__
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace Scan {
+  // A flat token stream shared by the WLP4 and MIPS lexers, stored as
+  // parallel arrays rather than one heap object per Token. All arrays
+  // live in a single block that doubles when it fills up. A Token is
+  // just an index: its kind, where its lexeme sits in the source
+  // buffer, its decoded integer value (0 for Tokens that are not
+  // literals) and the index of the line it was found on.
+  class TokenStream {
+    char *arena;
+    size_t count;
+    size_t capacity;
+    int64_t *values;
+    uint32_t *offsets;
+    uint32_t *lengths;
+    uint32_t *lines;
+    uint8_t *kinds;
+
+    // Carve the arrays for cap Tokens out of block, widest first so
+    // that every array is aligned
+    void layout(char *block, size_t cap){
+      arena = block;
+      capacity = cap;
+      values = reinterpret_cast<int64_t *>(block);
+      offsets = reinterpret_cast<uint32_t *>(values + cap);
+      lengths = offsets + cap;
+      lines = lengths + cap;
+      kinds = reinterpret_cast<uint8_t *>(lines + cap);
+    }
+    static size_t bytesFor(size_t cap){
+      return cap * (sizeof(int64_t) + 3 * sizeof(uint32_t) + sizeof(uint8_t));
+    }
+    void grow(){
+      size_t cap = capacity ? capacity * 2 : 1024;
+      char *block = static_cast<char *>(std::malloc(bytesFor(cap)));
+      if(!block) throw std::bad_alloc();
+      int64_t *oldValues = values;
+      uint32_t *oldOffsets = offsets, *oldLengths = lengths, *oldLines = lines;
+      uint8_t *oldKinds = kinds;
+      char *oldArena = arena;
+      layout(block, cap);
+      if(count){
+        std::memcpy(values, oldValues, count * sizeof(int64_t));
+        std::memcpy(offsets, oldOffsets, count * sizeof(uint32_t));
+        std::memcpy(lengths, oldLengths, count * sizeof(uint32_t));
+        std::memcpy(lines, oldLines, count * sizeof(uint32_t));
+        std::memcpy(kinds, oldKinds, count * sizeof(uint8_t));
+      }
+      std::free(oldArena);
+    }
+    // Not copyable, the arena is freed exactly once
+    TokenStream(const TokenStream&);
+    TokenStream& operator=(const TokenStream&);
+  public:
+    TokenStream() : arena(nullptr), count(0), capacity(0), values(nullptr),
+      offsets(nullptr), lengths(nullptr), lines(nullptr), kinds(nullptr){}
+    ~TokenStream(){ std::free(arena); }
+
+    void push(uint8_t kind, uint32_t offset, uint32_t length, int64_t value, uint32_t line){
+      if(count == capacity) grow();
+      kinds[count] = kind;
+      offsets[count] = offset;
+      lengths[count] = length;
+      values[count] = value;
+      lines[count] = line;
+      ++count;
+    }
+    // Append the Tokens of other, whose line indexes are counted
+    // from lineBase in this stream
+    void append(const TokenStream &other, uint32_t lineBase){
+      while(capacity - count < other.count) grow();
+      std::memcpy(values + count, other.values, other.count * sizeof(int64_t));
+      std::memcpy(offsets + count, other.offsets, other.count * sizeof(uint32_t));
+      std::memcpy(lengths + count, other.lengths, other.count * sizeof(uint32_t));
+      std::memcpy(kinds + count, other.kinds, other.count * sizeof(uint8_t));
+      for(size_t i = 0; i < other.count; ++i)
+        lines[count + i] = other.lines[i] + lineBase;
+      count += other.count;
+    }
+    // Forget every Token but keep the memory for reuse
+    void clear(){ count = 0; }
+
+    size_t size() const{ return count; }
+    uint8_t kind(size_t i) const{ return kinds[i]; }
+    uint32_t offset(size_t i) const{ return offsets[i]; }
+    uint32_t length(size_t i) const{ return lengths[i]; }
+    int64_t value(size_t i) const{ return values[i]; }
+    uint32_t line(size_t i) const{ return lines[i]; }
+  };
+}
+#endif
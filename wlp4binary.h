@@ -0,0 +1,61 @@
+#ifndef __WLP4BINARY_H__
+#define __WLP4BINARY_H__
+#include <cstddef>
+#include <cstdint>
+#include "wlp4grammar.h"
+
+// Compact binary forms of the streams between the stages of the
+// pipeline.
+//
+// The token stream that wlp4scan -b writes and wlp4parse reads in place
+// of "KIND lexeme" text lines. It starts with tokenMagic;
+// after that each Token is one byte holding its WLP4::Terminal, followed,
+// for ID and NUM only, by the length of the lexeme as a varint and the
+// lexeme itself. Every other terminal has a fixed spelling.
+namespace WLP4 {
+	// The first byte can never start a line of the text format
+	const char tokenMagic[4] = { '\x7f', 'W', '4', 'T' };
+
+	inline bool hasLexeme(unsigned terminal) {
+		return terminal == ID || terminal == NUM;
+	}
+
+	// The binary derivation that wlp4parse -b writes and wlp4gen reads
+	// in place of the text rule lines. After derivationMagic it lists the
+	// nodes of the parse tree in preorder: an interior node is the byte
+	// holding its rule id, and a leaf is LEAF | its symbol id, followed by
+	// a varint length and the lexeme unless the symbol is a terminal with
+	// a fixed spelling.
+	const char derivationMagic[4] = { '\x7f', 'W', '4', 'D' };
+	const unsigned char LEAF = 0x80;
+
+	inline bool fixedSpelling(unsigned symbol) {
+		return symbol < NUM_TERMINALS && terminalSpellings[symbol] != nullptr;
+	}
+
+	// Write v to out as an LEB128 varint, seven bits per byte with the
+	// high bit set on all but the last byte. Returns the number of bytes
+	// written, at most five.
+	inline size_t encodeVarint(uint32_t v, char *out) {
+		size_t n = 0;
+		while (v >= 0x80) {
+			out[n++] = static_cast<char>(v | 0x80);
+			v >>= 7;
+		}
+		out[n++] = static_cast<char>(v);
+		return n;
+	}
+
+	// Read a varint from [p, end) into v. Returns the position after it,
+	// or null if the input ends inside it or it is longer than five bytes.
+	inline const char *decodeVarint(const char *p, const char *end, uint32_t &v) {
+		v = 0;
+		for (int shift = 0; p != end && shift < 35; shift += 7) {
+			unsigned char c = *p++;
+			v |= static_cast<uint32_t>(c & 0x7f) << shift;
+			if (!(c & 0x80)) return p;
+		}
+		return nullptr;
+	}
+}
+#endif
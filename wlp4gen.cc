@@ -1,177 +1,233 @@
 #include <iostream>
-#include <sstream>
 #include <string>
 #include <algorithm>
 #include <vector>
 #include <unordered_map>
-#include <unordered_set>
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <cstdlib>
+#include <cerrno>
+#include <climits>
+#include "wlp4binary.h"
+#include "intparse.h"
+#include "mipscode.h"
+#include "arena.h"
 
 using namespace std;
+
+// The type of a value, as the type checker tags expression nodes with it
+enum ValueType : unsigned char {
+	UNCHECKED,
+	INT_VALUE,
+	POINTER_VALUE
+};
+
 namespace {
-	unordered_set<string> nonLeafNodeRule = {
-		"procedures main",
-		"params paramlist",
-		"paramlist dcl",
-		"type INT",
-		"expr term",
-		"term factor",
-		"factor ID"  ,
-		"factor NUM",
-		"factor NULL" ,
-		"arglist expr",
-		"lvalue ID"
-	};
-	unordered_set<string> terminals = {
-		"AMP",
-		"BECOMES",
-		"BOF",
-		"COMMA",
-		"DELETE",
-		"ELSE",
-		"EOF",
-		"EQ",
-		"GE",
-		"GT",
-		"ID",
-		"IF",
-		"INT",
-		"LBRACE",
-		"LBRACK",
-		"LE",
-		"LPAREN",
-		"LT",
-		"MINUS",
-		"NE",
-		"NEW",
-		"NULL",
-		"NUM",
-		"PCT",
-		"PLUS",
-		"PRINTLN",
-		"RBRACE",
-		"RBRACK",
-		"RETURN",
-		"RPAREN",
-		"SEMI",
-		"SLASH",
-		"STAR",
-		"WAIN",
-		"WHILE"
-	};
-	unordered_set<string> nonTerminals = {
-		"start",
-		"dcl",
-		"dcls",
-		"expr",
-		"factor",
-		"lvalue",
-		"procedure",
-		"procedures",
-		"main",
-		"params",
-		"paramlist",
-		"statement",
-		"statements",
-		"term",
-		"test",
-		"type",
-		"arglist",
-		"start"
-	};
-	unordered_set<string> procedureRules = {
-		"procedure INT ID LPAREN params RPAREN LBRACE dcls statements RETURN expr SEMI RBRACE",
-		"main INT WAIN LPAREN dcl COMMA dcl RPAREN LBRACE dcls statements RETURN expr SEMI RBRACE"
-	};
-	unordered_set<string> idRules = {
-		"dcl type ID",
-		"factor ID",
-		"lvalue ID",
-		"factor ID LPAREN RPAREN",
-		"factor ID LPAREN arglist RPAREN"
+	const char *typeName(ValueType type) {
+		return type == POINTER_VALUE ? "int*" : "int";
+	}
+
+	// Every lexeme is interned when its leaf is built, so that a node
+	// holds just an id and symbol and procedure tables are keyed by small
+	// integers
+	unordered_map<string, int> lexemeIds;
+	vector<string> lexemeNames;
+
+	int intern(const string &name) {
+		unordered_map<string, int>::const_iterator found = lexemeIds.find(name);
+		if (found != lexemeIds.end()) return found->second;
+		lexemeIds.emplace(name, lexemeNames.size());
+		lexemeNames.push_back(name);
+		return lexemeNames.size() - 1;
+	}
+
+	// The runtime procedures every program imports. They are the first
+	// labels of the program, so these are their label ids.
+	enum RuntimeLabel {
+		PRINT_LABEL,
+		NEW_LABEL,
+		DELETE_LABEL,
+		INIT_LABEL,
+		NUM_RUNTIME_LABELS
 	};
+	const char *const runtimeNames[NUM_RUNTIME_LABELS] = { "print", "new", "delete", "init" };
+
+	// Runs task(i) for every i below n on up to jobs threads, the calling
+	// thread among them, each taking the next i as it becomes free. Then
+	// rethrows what the task with the lowest i threw, if any did, so that
+	// the error reported does not depend on the number of threads.
+	template <typename Task>
+	void runInParallel(size_t n, unsigned jobs, Task task) {
+		vector<std::exception_ptr> errors(n);
+		std::atomic<size_t> next(0);
+		auto work = [&]() {
+			for (size_t i; (i = next++) < n; ) {
+				try {
+					task(i);
+				}
+				catch (...) {
+					errors[i] = std::current_exception();
+				}
+			}
+		};
+		vector<std::thread> threads;
+		for (unsigned k = 1; k < jobs && k < n; k++) threads.push_back(std::thread(work));
+		work();
+		for (size_t k = 0; k < threads.size(); k++) threads[k].join();
+		for (size_t i = 0; i < n; i++) {
+			if (errors[i]) std::rethrow_exception(errors[i]);
+		}
+	}
 }
 
+// A node of the parse tree: the production it was reduced by and its
+// children, or a leaf's terminal and lexeme. Nodes and their arrays of
+// children are carved out of the ConstructionStack's Arena and released
+// all at once with it, so a Node is never destructed.
 class Node {
 public:
+	Node **children;
 	int numOfChildren;
-	string type;
-	string lexeme;
-	string reduceRule;
-	vector<string> childrenTypes;
-	vector<Node *> children;
-	Node(string reduceRule);
-	// FindProcedure(vector<Procedure *> &procedures);
-	// AnalyzeProcedure(Procedure & procedure);
-	void addChild(Node * child);
-	~Node();
+	// The interned lexeme of a leaf, or -1
+	int lexeme;
+	// The production the node was reduced by, or -1 for a leaf
+	int16_t rule;
+	// The left-hand side of the production or the terminal of the leaf,
+	// or -1 for a text line that names no symbol
+	int16_t symbol;
+	// Set on expr, term, factor and lvalue nodes by the type checker
+	ValueType valueType;
+	// A node with room for numOfChildren children, which are filled in
+	// as they are built
+	static Node *make(Arena &arena, int rule, int symbol, int numOfChildren, int lexeme);
+	// The interior node for a rule
+	static Node *make(Arena &arena, int rule);
+	// A leaf of a binary derivation
+	static Node *make(Arena &arena, int symbol, const string &lexeme);
+	// A line of a text derivation
+	static Node *make(Arena &arena, const string &line);
+	const string &text() const {
+		return lexemeNames[lexeme];
+	}
 	void print();
 };
 
-Node::Node(string reduceRule) : reduceRule{ reduceRule } {
-	numOfChildren = 0;
-	type = "";
-	lexeme = "";
-	int n = std::count(reduceRule.begin(), reduceRule.end(), ' ');
-	if (n == 0) {
-		// disappear reduceRule
-		this->type = reduceRule;
-		this->lexeme = "";
-		this->numOfChildren = 0;
-		return;
+namespace {
+	// The text of each rule, as the text derivation spells it
+	const vector<string> &ruleStrings() {
+		static vector<string> strings;
+		if (strings.empty()) {
+			for (int r = 0; r < WLP4::NUM_RULES; r++) {
+				string s = WLP4::symbolNames[WLP4::rules[r].lhs];
+				for (int i = 0; i < WLP4::rules[r].length; i++) {
+					s += " ";
+					s += WLP4::symbolNames[WLP4::rules[r].rhs[i]];
+				}
+				strings.push_back(s);
+			}
+		}
+		return strings;
 	}
 
-	if (n == 1) {
-		// first check if that is part of the rule 
-		if (nonLeafNodeRule.find(reduceRule) != nonLeafNodeRule.end()) {
-			// part of the rule, not a leaf
-			this->type = reduceRule.substr(0, reduceRule.find(" "));
-			this->lexeme = "";
-			this->numOfChildren = 1;
-			return;
+	// The production a line of the text derivation reduces by, or -1 if
+	// the line is a terminal
+	int ruleOf(const string &line) {
+		static unordered_map<string, int> ids;
+		if (ids.empty()) {
+			for (int r = 0; r < WLP4::NUM_RULES; r++) {
+				ids[ruleStrings()[r]] = r;
+			}
 		}
-		// no kids, this is a leaf
-		this->type = reduceRule.substr(0, reduceRule.find(" "));
-		this->lexeme = reduceRule.substr(reduceRule.find(" ") + 1, reduceRule.length() - reduceRule.find(" ") - 1);
-		this->numOfChildren = 0;
-		return;
+		unordered_map<string, int>::const_iterator found = ids.find(line);
+		return found == ids.end() ? -1 : found->second;
 	}
-	// now we need to seperate those children types
-	std::istringstream iss(reduceRule);
-	iss >> this->type;
-	this->lexeme = "";
-	this->numOfChildren = n;
-	for (int i = 0; i < numOfChildren; i++) {
-		string sub;
-		iss >> sub;
-		childrenTypes.push_back(sub);
+
+	// The symbol a text derivation names, or -1
+	int symbolOf(const string &name) {
+		static unordered_map<string, int> ids;
+		if (ids.empty()) {
+			for (int symbol = 0; symbol < WLP4::NUM_SYMBOLS; symbol++) {
+				ids[WLP4::symbolNames[symbol]] = symbol;
+			}
+		}
+		unordered_map<string, int>::const_iterator found = ids.find(name);
+		return found == ids.end() ? -1 : found->second;
+	}
+
+	// The value of a NUM leaf, which the scanner has already checked
+	// fits in a word
+	int32_t numValue(const Node *num) {
+		const string &lexeme = num->text();
+		uint64_t value;
+		if (!Scan::decimalValue(lexeme.data(), lexeme.data() + lexeme.size(), 2147483647, value)) {
+			throw string("ERROR: Numeric literal out of range: " + lexeme);
+		}
+		return static_cast<int32_t>(value);
 	}
 }
 
-void Node::addChild(Node * child) {
-	this->children.push_back(child);
-};
+Node *Node::make(Arena &arena, int rule, int symbol, int numOfChildren, int lexeme) {
+	Node *node = new (arena.allocateArray<Node>(1)) Node;
+	node->children = numOfChildren ? arena.allocateArray<Node *>(numOfChildren) : nullptr;
+	node->numOfChildren = numOfChildren;
+	node->lexeme = lexeme;
+	node->rule = rule;
+	node->symbol = symbol;
+	node->valueType = UNCHECKED;
+	return node;
+}
 
-Node::~Node() {
-	for (vector<Node *>::iterator it = children.begin(); it != children.end(); it++) {
-		delete *it;
-	}
+Node *Node::make(Arena &arena, int rule) {
+	const WLP4::Rule &r = WLP4::rules[rule];
+	return make(arena, rule, r.lhs, r.length, -1);
+}
+
+Node *Node::make(Arena &arena, int symbol, const string &lexeme) {
+	return make(arena, -1, symbol, 0, intern(lexeme));
+}
+
+// A rule line has one space between its symbols, and a terminal line
+// one space between the terminal and its lexeme
+Node *Node::make(Arena &arena, const string &line) {
+	int rule = ruleOf(line);
+	if (rule >= 0) return make(arena, rule);
+	size_t space = line.find(' ');
+	int symbol = symbolOf(line.substr(0, space));
+	if (space == string::npos) return make(arena, -1, symbol, 0, -1);
+	int n = std::count(line.begin(), line.end(), ' ');
+	if (n > 1) {
+		// not a line of a derivation; keep its shape
+		return make(arena, -1, symbol, n, -1);
+	}
+	return make(arena, -1, symbol, 0, intern(line.substr(space + 1)));
 }
 
 void Node::print() {
-	cout << this->reduceRule << endl;
-	for (vector<Node *>::iterator it = this->children.begin(); it != this->children.end(); ++it) {
-		(*it)->print();
+	if (rule >= 0) {
+		cout << ruleStrings()[rule] << endl;
+	}
+	else {
+		cout << (symbol >= 0 ? WLP4::symbolNames[symbol] : "?");
+		if (lexeme >= 0) cout << " " << text();
+		cout << endl;
+	}
+	for (int i = 0; i < numOfChildren; i++) {
+		children[i]->print();
 	}
 }
 class Procedure;
 class ConstructionStack {
 public:
+	// Every node of the tree, released with the stack
+	Arena arena;
 	vector<Node *> nodeStack;
 	vector<Procedure *> procedures;
+	// The procedures defined so far, by interned name
+	unordered_map<int, Procedure *> procedureTable;
 	Procedure *main;
-	static int ifCount;
-	static int whileCount;
-	vector<string> mipsCodePool;
+	// The whole program, which each procedure's code is appended to
+	MIPS::Program program;
 	ConstructionStack() {
 		main = nullptr;
 	};
@@ -179,53 +235,67 @@ public:
 	~ConstructionStack();
 	void putOnNode(Node *);
 	void print();
-	void outputMips();
-	void analyzeNodeAfterConstruct();
-	void findProcedures(Node * startNode);
+	// Writes the program as a MERL module, or as assembly text
+	void outputMips(bool assembly);
+	void analyzeNodeAfterConstruct(unsigned jobs);
+	void findProcedures(Node * startNode, unsigned jobs);
 	void printProcedures();
 };
 
+// A variable of a procedure: its type and where it lives relative to $29
+struct Variable {
+	ValueType type;
+	int offset;
+};
+
 class Procedure {
 public:
 	Node *rootNode;
 	string name;
 	string returnType;
-	unordered_map<string, string> localVariables;
-	// first is type, second is id
-	vector<std::pair<string, string>> parameterList;
-	vector<Procedure *> &procedures;
-	vector<string> &mipsCodePool;
-	vector<vector<string>> symbolTable;
-	Procedure(Node *rootNode, vector<Procedure *> &procedures, vector<string> &mipsCodePool);
+	// The variables by interned identifier, and the identifiers in the
+	// order they were declared: parameters first, then locals
+	unordered_map<int, Variable> symbolTable;
+	vector<int> declarationOrder;
+	// The types of the parameters, which every call is checked against
+	vector<ValueType> signature;
+	unordered_map<int, Procedure *> &procedureTable;
+	// Where the procedure stands among the procedures of the source; it
+	// may call itself and those before it
+	int index;
+	// The label of the procedure's first instruction, a label of the
+	// whole program; wain has none
+	int entryLabel;
+	// The procedure's own code, to be appended to the program. Its labels
+	// and the numbers in their names follow on from those of the
+	// procedures generated before it, so that the program comes out the
+	// same whichever order the procedures are generated in.
+	MIPS::Program program;
+	int ifCount;
+	int whileCount;
+	// How many if and while statements the body has, counted by the
+	// type checker
+	int ifStatements;
+	int whileStatements;
+	Procedure(Node *rootNode, int index, unordered_map<int, Procedure *> &procedureTable, MIPS::Program &linked);
 	~Procedure();
-	void buildSymbolTable();
+	void printSymbolTable();
 	void storeLocalVariableOnRAM();
 	void print();
 	void processProcedure();
 	void processParams(Node *params);
 	void processParamlist(Node *paramlist);
 	void processDcl(Node * dcl, bool param);
-	void processDcls(Node * dcls);
-	void processStatements(Node *statements);
-	void processStatement(Node *statement);
-	void processLvalue(Node *lvalue);
-	void processExpr(Node *Expr);
-	void processTest(Node *test);
-	void processTerm(Node *term);
-	void processFactor(Node *factor);
-	void processID(Node *ID);
-	void processNum(Node *NUM);
-	void typeCheckStatements(Node *statements);
-	void typeCheckStatement(Node *statement);
-	void typeCheckTest(Node *test);
-	void typeCheckDCLS(Node *dcls);
-	string typeDcl(Node *dcl);
-	string typeExpr(Node *expr);
-	string typeTerm(Node *term);
-	string typeFactor(Node *factor);
-	string typeID(Node *ID);
-	string typeLvalue(Node *lvalue);
-	vector<string> processArglist(Node *argList);
+	ValueType typeDcl(Node *dcl);
+	void checkDcls(Node *dcls);
+	void checkStatements(Node *statements);
+	void checkStatement(Node *statement);
+	void checkTest(Node *test);
+	ValueType checkExpr(Node *expr);
+	ValueType checkTerm(Node *term);
+	ValueType checkFactor(Node *factor);
+	ValueType checkID(Node *ID);
+	ValueType checkLvalue(Node *lvalue);
 
 	// mips code generation part:
 	void generateCode();
@@ -244,205 +314,150 @@ public:
 
 void Procedure::generateTest(Node *test) {
 	generateExpr(test->children[0]);
-	this->mipsCodePool.push_back("sw $3, -4($30)");
-	this->mipsCodePool.push_back("sub $30, $30, $4");
+	program.sw(3, -4, 30);
+	program.sub(30, 30, 4);
 	generateExpr(test->children[2]);
-	string typeE1 = typeExpr(test->children[0]);
+	ValueType typeE1 = test->children[0]->valueType;
 	
 	// we pop the value of expr from RAM,store to $5
-	this->mipsCodePool.push_back("add $30, $30, $4");
-	this->mipsCodePool.push_back("lw $5, -4($30)");
-
-	if (typeE1 == "int") {
-		if (test->reduceRule == "test expr EQ expr") {
-			this->mipsCodePool.push_back("slt $6, $3, $5");
-			this->mipsCodePool.push_back("slt $7, $5, $3");
-			this->mipsCodePool.push_back("add $3, $6, $7");
-			this->mipsCodePool.push_back("sub $3, $11, $3");
-		}
-		else if (test->reduceRule == "test expr NE expr") {
-			this->mipsCodePool.push_back("slt $6, $3, $5");
-			this->mipsCodePool.push_back("slt $7, $5, $3");
-			this->mipsCodePool.push_back("add $3, $6, $7");
-		}
-		else if (test->reduceRule == "test expr LT expr") {
-			this->mipsCodePool.push_back("slt $3, $5, $3");
-		}
-		else if (test->reduceRule == "test expr LE expr") {
-			this->mipsCodePool.push_back("slt $3, $3, $5");
-			this->mipsCodePool.push_back("sub $3, $11, $3");
-		}
-		else if (test->reduceRule == "test expr GE expr") {
-			this->mipsCodePool.push_back("slt $3, $5, $3");
-			this->mipsCodePool.push_back("sub $3, $11, $3");
-		}
-		else if (test->reduceRule == "test expr GT expr") {
-			this->mipsCodePool.push_back("slt $3, $3, $5");
-		}
-	}
-	else {
-		if (test->reduceRule == "test expr EQ expr") {
-			this->mipsCodePool.push_back("sltu $6, $3, $5");
-			this->mipsCodePool.push_back("sltu $7, $5, $3");
-			this->mipsCodePool.push_back("add $3, $6, $7");
-			this->mipsCodePool.push_back("sub $3, $11, $3");
-		}
-		else if (test->reduceRule == "test expr NE expr") {
-			this->mipsCodePool.push_back("sltu $6, $3, $5");
-			this->mipsCodePool.push_back("sltu $7, $5, $3");
-			this->mipsCodePool.push_back("add $3, $6, $7");
-		}
-		else if (test->reduceRule == "test expr LT expr") {
-			this->mipsCodePool.push_back("sltu $3, $5, $3");
-		}
-		else if (test->reduceRule == "test expr LE expr") {
-			this->mipsCodePool.push_back("sltu $3, $3, $5");
-			this->mipsCodePool.push_back("sub $3, $11, $3");
-		}
-		else if (test->reduceRule == "test expr GE expr") {
-			this->mipsCodePool.push_back("sltu $3, $5, $3");
-			this->mipsCodePool.push_back("sub $3, $11, $3");
-		}
-		else if (test->reduceRule == "test expr GT expr") {
-			this->mipsCodePool.push_back("sltu $3, $3, $5");
-		}
+	program.add(30, 30, 4);
+	program.lw(5, -4, 30);
+
+	// pointers compare as unsigned addresses
+	auto slt = [this, typeE1](int d, int s, int t) {
+		if (typeE1 == INT_VALUE) program.slt(d, s, t);
+		else program.sltu(d, s, t);
+	};
+	switch (test->rule) {
+	case WLP4::TEST_EQ:
+		slt(6, 3, 5);
+		slt(7, 5, 3);
+		program.add(3, 6, 7);
+		program.sub(3, 11, 3);
+		break;
+	case WLP4::TEST_NE:
+		slt(6, 3, 5);
+		slt(7, 5, 3);
+		program.add(3, 6, 7);
+		break;
+	case WLP4::TEST_LT:
+		slt(3, 5, 3);
+		break;
+	case WLP4::TEST_LE:
+		slt(3, 3, 5);
+		program.sub(3, 11, 3);
+		break;
+	case WLP4::TEST_GE:
+		slt(3, 5, 3);
+		program.sub(3, 11, 3);
+		break;
+	case WLP4::TEST_GT:
+		slt(3, 3, 5);
+		break;
 	}
 }
 
 Node *Procedure::generateLvalue(Node *lvalue) {
-	if ((lvalue->reduceRule == "lvalue ID") || 
-		(lvalue->reduceRule == "lvalue STAR factor")) {
-		
+	switch (lvalue->rule) {
+	case WLP4::LVALUE_ID:
+	case WLP4::LVALUE_STAR:
 		return lvalue;
-	}
-	//if (lvalue->reduceRule == "lvalue STAR factor") {
-	//	// this is something aboubt pointer, we think of it later
-
-	//}
-	if (lvalue->reduceRule == "lvalue LPAREN lvalue RPAREN") {
+	case WLP4::LVALUE_PAREN:
 		return generateLvalue(lvalue->children[1]);
 	}
 }
 
 void Procedure::generateID(Node *ID) {
-	string nameID = ID->lexeme;
-	for (int i = 0; i < symbolTable.size(); i++) {
-		if (symbolTable[i][0] == nameID) {
-			string location = symbolTable[i][2];
-			string loadStr = "lw $3, " + location;
-			loadStr = loadStr + "($29)";
-			this->mipsCodePool.push_back(loadStr);
-			return;
-		}
-	}
+	program.lw(3, symbolTable[ID->lexeme].offset, 29);
 }
 
 void Procedure::generateFactor(Node *factor) {
+	switch (factor->rule) {
 	// if the id is a variable
-	if (factor->reduceRule == "factor ID") {
+	case WLP4::FACTOR_ID:
 		generateID(factor->children[0]);
 		return;
-	}
 	// for rule: factor -> NUM, NULL, do nothing for now
-	if (factor->reduceRule == "factor NUM") {
-		string numStr = factor->children[0]->lexeme;
-		this->mipsCodePool.push_back("lis $3");
-		string wordStr = ".word " + numStr;
-		this->mipsCodePool.push_back(wordStr);
+	case WLP4::FACTOR_NUM: {
+		program.lis(3);
+		program.word(numValue(factor->children[0]));
 		return;
 	}
-
-	if (factor->reduceRule == "factor NULL") {
+	case WLP4::FACTOR_NULL:
 		// this is null
-		this->mipsCodePool.push_back("add $3, $0, $11");
+		program.add(3, 0, 11);
 		return;
-	}
-
 	// for rule: factor -> STAR factor
-	if (factor->reduceRule == "factor STAR factor") {
+	case WLP4::FACTOR_STAR:
 		// this is about pointer, we think aboubt it later
 		generateFactor(factor->children[1]);
-		this->mipsCodePool.push_back("lw $3, 0($3)");
+		program.lw(3, 0, 3);
 		return;
-	}
 	// for rule: factor -> LPAREN expr RPAREN
-	if (factor->reduceRule == "factor LPAREN expr RPAREN") {
+	case WLP4::FACTOR_PAREN:
 		generateExpr(factor->children[1]);
 		return;
-	}
 	// for rule: factor -> AMP lvalue
-	if (factor->reduceRule == "factor AMP lvalue") {
+	case WLP4::FACTOR_AMP: {
 		// this is about pointer, we think aboubt it later
 		Node *lvalue = generateLvalue(factor->children[1]);
-		if (lvalue->reduceRule == "lvalue ID") {
-			string IDName = lvalue->children[0]->lexeme;
-			string location = "";
-			for (int i = 0; i < symbolTable.size(); i++) {
-				if (symbolTable[i][0] == IDName) {
-					location = symbolTable[i][2];
-				}
-			}
-			this->mipsCodePool.push_back("lis $3");
-			string wordStr = ".word " + location;
-			this->mipsCodePool.push_back(wordStr);
-			this->mipsCodePool.push_back("add $3, $3, $29");
+		if (lvalue->rule == WLP4::LVALUE_ID) {
+			int location = symbolTable[lvalue->children[0]->lexeme].offset;
+			program.lis(3);
+			program.word(location);
+			program.add(3, 3, 29);
 		}
-		else if (lvalue->reduceRule == "lvalue STAR factor") {
+		else if (lvalue->rule == WLP4::LVALUE_STAR) {
 			generateFactor(lvalue->children[1]);
 		}
 		return;
 	}
 	// for rule: factor -> NEW INT LBRACK expr RBRACK
-	if (factor->reduceRule == "factor NEW INT LBRACK expr RBRACK") {
+	case WLP4::FACTOR_NEW:
 		// this is about memory , we think about it later
 		generateExpr(factor->children[3]);
-		this->mipsCodePool.push_back("add $1, $3, $0");
-		this->mipsCodePool.push_back("lis $10");
-		this->mipsCodePool.push_back(".word new");
-		this->mipsCodePool.push_back("jalr $10");
-		this->mipsCodePool.push_back("bne $0, $3, 1");
-		this->mipsCodePool.push_back("add $3, $0, $11");
+		program.add(1, 3, 0);
+		program.lis(10);
+		program.wordLabel(NEW_LABEL);
+		program.jalr(10);
+		program.bne(0, 3, 1);
+		program.add(3, 0, 11);
 		return;
-	}
 	// for rule: factor -> ID LPAREN RPAREN
-	if (factor->reduceRule == "factor ID LPAREN RPAREN"
-		|| factor->reduceRule == "factor ID LPAREN arglist RPAREN") {
+	case WLP4::FACTOR_CALL:
+	case WLP4::FACTOR_CALL_ARGS: {
 		// this is function call, we think about it later
-		string functionName = "F"+factor->children[0]->lexeme;
-		string wordFunc = ".word " + functionName;
+		bool hasArgs = factor->rule == WLP4::FACTOR_CALL_ARGS;
+		int entryLabel = procedureTable.find(factor->children[0]->lexeme)->second->entryLabel;
 		int paramNum = 0;
 		// first store the $29 and $30
-		this->mipsCodePool.push_back("sw $29, -4($30)");
-		this->mipsCodePool.push_back("sub $30, $30, $4");
+		program.sw(29, -4, 30);
+		program.sub(30, 30, 4);
 		if (this->name != "wain") {
-			this->mipsCodePool.push_back("sw $31, -4($30)");
-			this->mipsCodePool.push_back("sub $30, $30, $4");
+			program.sw(31, -4, 30);
+			program.sub(30, 30, 4);
 		}
-		if (factor->reduceRule == "factor ID LPAREN arglist RPAREN") {
+		if (hasArgs) {
 			paramNum = generateArgList(factor->children[2]);
 		}
-		this->mipsCodePool.push_back("lis $5");
-		this->mipsCodePool.push_back(wordFunc);
-		this->mipsCodePool.push_back("jalr $5");
-		if (factor->reduceRule == "factor ID LPAREN arglist RPAREN") {
+		program.lis(5);
+		program.wordLabel(entryLabel);
+		program.jalr(5);
+		if (hasArgs) {
 			// we need to pop off the parameters we just pushed
-			int addUp = paramNum * 4;
-			stringstream ss;
-			ss << addUp;
-			string strOffset = ss.str();
-			string strWordOffset = ".word " + strOffset;
-			mipsCodePool.push_back("lis $5");
-			mipsCodePool.push_back(strWordOffset);
-			mipsCodePool.push_back("add $30, $30, $5");
+			program.lis(5);
+			program.word(paramNum * 4);
+			program.add(30, 30, 5);
 		}
 		if (this->name != "wain") {
-			this->mipsCodePool.push_back("add $30, $30, $4");
-			this->mipsCodePool.push_back("lw $31, -4($30)");
+			program.add(30, 30, 4);
+			program.lw(31, -4, 30);
 		}
-		this->mipsCodePool.push_back("add $30, $30, $4");
-		this->mipsCodePool.push_back("lw $29, -4($30)");
+		program.add(30, 30, 4);
+		program.lw(29, -4, 30);
 		return;
 	}
+	}
 }
 
 int Procedure::generateArgList(Node *arglist) {
@@ -450,190 +465,187 @@ int Procedure::generateArgList(Node *arglist) {
 	while (arglist->numOfChildren == 3) {
 		answer++;
 		generateExpr(arglist->children[0]);
-		this->mipsCodePool.push_back("sw $3, -4($30)");
-		this->mipsCodePool.push_back("sub $30, $30, $4");
+		program.sw(3, -4, 30);
+		program.sub(30, 30, 4);
 		arglist = arglist->children[2];
 	}
 	generateExpr(arglist->children[0]);
-	this->mipsCodePool.push_back("sw $3, -4($30)");
-	this->mipsCodePool.push_back("sub $30, $30, $4");
+	program.sw(3, -4, 30);
+	program.sub(30, 30, 4);
 	return answer + 1;
 }
 
 void Procedure::generateTerm(Node *term) {
-	if (term->reduceRule == "term factor") {
+	if (term->rule == WLP4::TERM_FACTOR) {
 		generateFactor(term->children[0]);
 	}
 	else {
 		generateTerm(term->children[0]);
 		// push the result of term to RAM
-		this->mipsCodePool.push_back("sw $3, -4($30)");
-		this->mipsCodePool.push_back("sub $30, $30, $4");
+		program.sw(3, -4, 30);
+		program.sub(30, 30, 4);
 		generateFactor(term->children[2]);
 		// we pop the value of expr from RAM,store to $5
-		this->mipsCodePool.push_back("add $30, $30, $4");
-		this->mipsCodePool.push_back("lw $5, -4($30)");
-		if (term->reduceRule == "term term STAR factor") {
+		program.add(30, 30, 4);
+		program.lw(5, -4, 30);
+		switch (term->rule) {
+		case WLP4::TERM_STAR:
 			// then multiplication
-			this->mipsCodePool.push_back("mult $5, $3");
-			this->mipsCodePool.push_back("mflo $3");
-		}
-		else if (term->reduceRule == "term term SLASH factor") {
+			program.mult(5, 3);
+			program.mflo(3);
+			break;
+		case WLP4::TERM_SLASH:
 			// then division
-			this->mipsCodePool.push_back("div $5, $3");
-			this->mipsCodePool.push_back("mflo $3");
-		}
-		else if (term->reduceRule == "term term PCT factor") {
+			program.div(5, 3);
+			program.mflo(3);
+			break;
+		case WLP4::TERM_PCT:
 			// then division
-			this->mipsCodePool.push_back("div $5, $3");
-			this->mipsCodePool.push_back("mfhi $3");
+			program.div(5, 3);
+			program.mfhi(3);
+			break;
 		}
 	}
 }
 
 void Procedure::generateExpr(Node *expr) {
-	if (expr->reduceRule == "expr term") {
+	if (expr->rule == WLP4::EXPR_TERM) {
 		generateTerm(expr->children[0]);
 	}
 	else {
 		generateExpr(expr->children[0]);
 		// we push the result of expr to RAM
-		this->mipsCodePool.push_back("sw $3, -4($30)");
-		this->mipsCodePool.push_back("sub $30, $30, $4");
+		program.sw(3, -4, 30);
+		program.sub(30, 30, 4);
 		generateTerm(expr->children[2]);
-		string typeE = this->typeExpr(expr->children[0]);
-		string typeT = this->typeTerm(expr->children[2]);
+		ValueType typeE = expr->children[0]->valueType;
+		ValueType typeT = expr->children[2]->valueType;
 		// we pop the value of expr from RAM,store to $5
-		this->mipsCodePool.push_back("add $30, $30, $4");
-		this->mipsCodePool.push_back("lw $5, -4($30)");
-		if (expr->reduceRule == "expr expr PLUS term") {
-			if (typeE == "int" && typeT == "int") {
-				this->mipsCodePool.push_back("add $3, $5, $3");
+		program.add(30, 30, 4);
+		program.lw(5, -4, 30);
+		switch (expr->rule) {
+		case WLP4::EXPR_PLUS:
+			if (typeE == INT_VALUE && typeT == INT_VALUE) {
+				program.add(3, 5, 3);
 				return;
 			}
-			if (typeE == "int*" && typeT == "int") {
-				this->mipsCodePool.push_back("mult $3, $4");
-				this->mipsCodePool.push_back("mflo $3");
-				this->mipsCodePool.push_back("add $3, $5, $3");
+			if (typeE == POINTER_VALUE && typeT == INT_VALUE) {
+				program.mult(3, 4);
+				program.mflo(3);
+				program.add(3, 5, 3);
 				return;
 			}
-			if (typeE == "int" && typeT == "int*") {
-				this->mipsCodePool.push_back("mult $5, $4");
-				this->mipsCodePool.push_back("mflo $5");
-				this->mipsCodePool.push_back("add $3, $5, $3");
+			if (typeE == INT_VALUE && typeT == POINTER_VALUE) {
+				program.mult(5, 4);
+				program.mflo(5);
+				program.add(3, 5, 3);
 				return;
 			}
-		}
-		else if (expr->reduceRule == "expr expr MINUS term") {
-			if (typeE == "int" && typeT == "int") {
-				this->mipsCodePool.push_back("sub $3, $5, $3");
+			break;
+		case WLP4::EXPR_MINUS:
+			if (typeE == INT_VALUE && typeT == INT_VALUE) {
+				program.sub(3, 5, 3);
 				return;
 			}
-			if (typeE == "int*" && typeT == "int") {
-				this->mipsCodePool.push_back("mult $3, $4");
-				this->mipsCodePool.push_back("mflo $3");
-				this->mipsCodePool.push_back("sub $3, $5, $3");
+			if (typeE == POINTER_VALUE && typeT == INT_VALUE) {
+				program.mult(3, 4);
+				program.mflo(3);
+				program.sub(3, 5, 3);
 				return;
 			}
-			if (typeE == "int*" && typeT == "int*") {
-				this->mipsCodePool.push_back("sub $3, $5, $3");
-				this->mipsCodePool.push_back("divu $3, $4");
-				this->mipsCodePool.push_back("mflo $3");
+			if (typeE == POINTER_VALUE && typeT == POINTER_VALUE) {
+				program.sub(3, 5, 3);
+				program.divu(3, 4);
+				program.mflo(3);
 			}
+			break;
 		}
 	}
 }
 
 void Procedure::generateStatement(Node *statement) {
-	if (statement->reduceRule == "statement lvalue BECOMES expr SEMI") {
-		mipsCodePool.push_back(";; statement lvalue BECOMES expr SEMI");
+	switch (statement->rule) {
+	case WLP4::STATEMENT_ASSIGN: {
+		program.comment("statement lvalue BECOMES expr SEMI");
 		Node *lvalue = generateLvalue(statement->children[0]);
 		Node *expr = statement->children[2];
-		if (lvalue->reduceRule == "lvalue ID") {
+		if (lvalue->rule == WLP4::LVALUE_ID) {
 			generateExpr(expr);
-			string nameID = lvalue->children[0]->lexeme;
-			string location = "";
-			for (int i = 0; i < symbolTable.size(); i++) {
-				if (symbolTable[i][0] == nameID) {
-					location = symbolTable[i][2];
-				}
-			}
-			string swStr = "sw $3, " + location;
-			swStr = swStr + "($29)";
-			this->mipsCodePool.push_back(swStr);
+			program.sw(3, symbolTable[lvalue->children[0]->lexeme].offset, 29);
 		}
-		else if (lvalue->reduceRule == "lvalue STAR factor") {
+		else if (lvalue->rule == WLP4::LVALUE_STAR) {
 			// first put the value of expr on $3
 			generateExpr(expr);
-			this->mipsCodePool.push_back("sw $3, -4($30)");
-			this->mipsCodePool.push_back("sub $30, $30, $4");
+			program.sw(3, -4, 30);
+			program.sub(30, 30, 4);
 			// now we start to process lvalue
 			generateFactor(lvalue->children[1]);
 			// if it is a pointer, we already load the content of the pointer which is an address in $3
 			// then we need to store the value of expr to this address
-			this->mipsCodePool.push_back("add $30, $30, $4");
-			this->mipsCodePool.push_back("lw $5, -4($30)");
-			this->mipsCodePool.push_back("sw $5, 0($3)");
+			program.add(30, 30, 4);
+			program.lw(5, -4, 30);
+			program.sw(5, 0, 3);
 		}
+		break;
 	}
-	if (statement->reduceRule == "statement IF LPAREN test RPAREN LBRACE statements RBRACE ELSE LBRACE statements RBRACE") {
-		mipsCodePool.push_back(";; statement IF LPAREN test RPAREN LBRACE statements RBRACE ELSE LBRACE statements RBRACE");
+	case WLP4::STATEMENT_IF: {
+		program.comment("statement IF LPAREN test RPAREN LBRACE statements RBRACE ELSE LBRACE statements RBRACE");
 		Node *test = statement->children[2];
 		Node *firstStatements = statement->children[5];
 		Node *secondStatements = statement->children[9];
-		ConstructionStack::ifCount++;
-		stringstream ss;
-		ss << ConstructionStack::ifCount;
-		string count = ss.str();
-		string se = "se" + count;
-		string ee = "ee" + count;
+		ifCount++;
+		string count = to_string(ifCount);
+		int se = program.newLabel("se" + count);
+		int ee = program.newLabel("ee" + count);
 		generateTest(test);
-		this->mipsCodePool.push_back("beq $3, $0, "+ se);
+		program.beqLabel(3, 0, se);
 		generateStatements(firstStatements);
-		this->mipsCodePool.push_back("beq $0, $0, "+ ee);
-		this->mipsCodePool.push_back(se+":");
+		program.beqLabel(0, 0, ee);
+		program.label(se);
 		generateStatements(secondStatements);
-		this->mipsCodePool.push_back(ee+":");
+		program.label(ee);
+		break;
 	}
-	if (statement->reduceRule == "statement WHILE LPAREN test RPAREN LBRACE statements RBRACE") {
-		mipsCodePool.push_back(";; statement WHILE LPAREN test RPAREN LBRACE statements RBRACE");
+	case WLP4::STATEMENT_WHILE: {
+		program.comment("statement WHILE LPAREN test RPAREN LBRACE statements RBRACE");
 		Node *test = statement->children[2];
 		Node *statements = statement->children[5];
-		stringstream ss;
-		ConstructionStack::whileCount++;
-		ss << ConstructionStack::whileCount;
-		string count = ss.str();
-		string sw = "sw" + count;
-		string ew = "ew" + count;
-		this->mipsCodePool.push_back(sw+":");
+		whileCount++;
+		string count = to_string(whileCount);
+		int sw = program.newLabel("sw" + count);
+		int ew = program.newLabel("ew" + count);
+		program.label(sw);
 		generateTest(test);
-		this->mipsCodePool.push_back("beq $3, $0, " + ew);
+		program.beqLabel(3, 0, ew);
 		generateStatements(statements);
-		this->mipsCodePool.push_back("beq $0, $0, " + sw);
-		this->mipsCodePool.push_back(ew + ":");
-		
+		program.beqLabel(0, 0, sw);
+		program.label(ew);
+		break;
 	}
-	if (statement->reduceRule == "statement PRINTLN LPAREN expr RPAREN SEMI") {
-		mipsCodePool.push_back(";; statement PRINTLN LPAREN expr RPAREN SEMI");
+	case WLP4::STATEMENT_PRINTLN: {
+		program.comment("statement PRINTLN LPAREN expr RPAREN SEMI");
 		generateExpr(statement->children[2]);
-		this->mipsCodePool.push_back("add $1, $3, $0");
-		this->mipsCodePool.push_back("add $18, $31, $0");
+		program.add(1, 3, 0);
+		program.add(18, 31, 0);
 		
-		this->mipsCodePool.push_back("lis $10");
-		this->mipsCodePool.push_back(".word print");
-		this->mipsCodePool.push_back("jalr $10");
-		//this->mipsCodePool.push_back("add $17, $1, $0");
-		this->mipsCodePool.push_back("add $31, $18, $0");
-	}
-	if (statement->reduceRule == "statement DELETE LBRACK RBRACK expr SEMI") {
-		mipsCodePool.push_back(";; statement DELETE LBRACK RBRACK expr SEMI");
+		program.lis(10);
+		program.wordLabel(PRINT_LABEL);
+		program.jalr(10);
+		//program.add(17, 1, 0);
+		program.add(31, 18, 0);
+		break;
+	}
+	case WLP4::STATEMENT_DELETE: {
+		program.comment("statement DELETE LBRACK RBRACK expr SEMI");
 		//this is about memory, think about it later
 		generateExpr(statement->children[3]);
-		this->mipsCodePool.push_back("add $1, $3, $0");
-		this->mipsCodePool.push_back("beq $1, $11, 3");
-		this->mipsCodePool.push_back("lis $10");
-		this->mipsCodePool.push_back(".word delete");
-		this->mipsCodePool.push_back("jalr $10");
+		program.add(1, 3, 0);
+		program.beq(1, 11, 3);
+		program.lis(10);
+		program.wordLabel(DELETE_LABEL);
+		program.jalr(10);
+		break;
+	}
 	}
 }
 
@@ -649,130 +661,75 @@ void Procedure::generateCode() {
 		// for now we only generate code for wain
 		// first we try to ignore procedures, just focus on main
 		// setup prolog:
-		string firstParamType = typeDcl(rootNode->children[3]);
-		bool pointerType = firstParamType == "int*";
-		mipsCodePool.push_back(";; wain:");
-		mipsCodePool.push_back(";; prolog");
-		mipsCodePool.push_back("lis $4");
-		mipsCodePool.push_back(".word 4");
-		mipsCodePool.push_back("lis $11");
-		mipsCodePool.push_back(".word 1");
-		mipsCodePool.push_back("sw $31, -4($30)");
-		mipsCodePool.push_back("sub $30, $30, $4");
-		this->mipsCodePool.push_back("sub $29, $30, $4");
+		bool pointerType = typeDcl(rootNode->children[3]) == POINTER_VALUE;
+		program.comment("wain:");
+		program.comment("prolog");
+		program.lis(4);
+		program.word(4);
+		program.lis(11);
+		program.word(1);
+		program.sw(31, -4, 30);
+		program.sub(30, 30, 4);
+		program.sub(29, 30, 4);
 		if (pointerType) {
-			this->mipsCodePool.push_back("lis $10");
-			this->mipsCodePool.push_back(".word init");
-			this->mipsCodePool.push_back("jalr $10");
+			program.lis(10);
+			program.wordLabel(INIT_LABEL);
+			program.jalr(10);
 		}
 		else {
-			this->mipsCodePool.push_back("sw $2, -4($30)");
-			this->mipsCodePool.push_back("sub $30, $30, $4");
-			this->mipsCodePool.push_back("add $2, $0, $0");
-			this->mipsCodePool.push_back("lis $10");
-			this->mipsCodePool.push_back(".word init");
-			this->mipsCodePool.push_back("jalr $10");
-			this->mipsCodePool.push_back("add $30, $30, $4");
-			this->mipsCodePool.push_back("lw $2, -4($30)");
+			program.sw(2, -4, 30);
+			program.sub(30, 30, 4);
+			program.add(2, 0, 0);
+			program.lis(10);
+			program.wordLabel(INIT_LABEL);
+			program.jalr(10);
+			program.add(30, 30, 4);
+			program.lw(2, -4, 30);
 		}
 		//body part:
-		mipsCodePool.push_back(";; body");
+		program.comment("body");
 
-		this->buildSymbolTable();
 		// we print out symbol table as a comment
-		mipsCodePool.push_back(";; Symbol Table Generated");
-		for (int i = 0; i < symbolTable.size(); i++) {
-			string singleItem = ";;  ";
-			singleItem = singleItem + symbolTable[i][0] + "   " + symbolTable[i][1] + "   " + symbolTable[i][2];
-			this->mipsCodePool.push_back(singleItem); 
-		}
-		mipsCodePool.push_back(";; store local variables on RAM");
+		this->printSymbolTable();
+		program.comment("store local variables on RAM");
 		this->storeLocalVariableOnRAM();
-		mipsCodePool.push_back(";; start processing statement");
+		program.comment("start processing statement");
 		generateStatements(this->rootNode->children[9]);
-		mipsCodePool.push_back(";; start processing return");
+		program.comment("start processing return");
 		generateExpr(this->rootNode->children[11]);
 		//Epilog:
-		mipsCodePool.push_back(";; epilog");
-		mipsCodePool.push_back("add $30, $29, $4");
-		mipsCodePool.push_back("add $30, $30, $4");
-		mipsCodePool.push_back("lw $31, -4($30)");
-		mipsCodePool.push_back("jr $31");
+		program.comment("epilog");
+		program.add(30, 29, 4);
+		program.add(30, 30, 4);
+		program.lw(31, -4, 30);
+		program.jr(31);
 	}
 	else {
 		// this part is for procedures
 		// first put a lable for the start of the function
-		string lableStr = "F" + this->name + ":";
-		mipsCodePool.push_back(lableStr);
+		program.label(entryLabel);
 		// set $29
-		mipsCodePool.push_back("sub $29, $30, $4");
-
-		this->buildSymbolTable();
-		mipsCodePool.push_back(";; Symbol Table Generated");
-		for (int i = 0; i < symbolTable.size(); i++) {
-			string singleItem = ";;  ";
-			singleItem = singleItem + symbolTable[i][0] + "   " + symbolTable[i][1] + "   " + symbolTable[i][2];
-			this->mipsCodePool.push_back(singleItem); 
-		}
+		program.sub(29, 30, 4);
+
+		this->printSymbolTable();
 		this->storeLocalVariableOnRAM();
-		mipsCodePool.push_back(";; start processing statement");
+		program.comment("start processing statement");
 		generateStatements(this->rootNode->children[7]);
-		mipsCodePool.push_back(";; start processing return");
+		program.comment("start processing return");
 		generateExpr(this->rootNode->children[9]);
 		// ;; epilog
-		mipsCodePool.push_back("add $30, $29, $4");
-		mipsCodePool.push_back("jr $31");
+		program.add(30, 29, 4);
+		program.jr(31);
 	}
 }
 
-void Procedure::buildSymbolTable() {
-	if (this->name == "wain") {
-		int i = 0;
-		for (auto it = localVariables.begin(); it != localVariables.end(); it++, i = i - 4) {
-			vector<string> tempSymbolTableItem;
-			tempSymbolTableItem.push_back(it->first);
-			tempSymbolTableItem.push_back(it->second);
-			stringstream ss;
-			ss << i;
-			string strLocation = ss.str();
-			tempSymbolTableItem.push_back(strLocation);
-			this->symbolTable.push_back(tempSymbolTableItem);
-		}
-	}
-	else {
-		int numOfParam = this->parameterList.size();
-		int totalSize = numOfParam * 4;
-		for (int i = 0; i < this->parameterList.size(); i++) {
-			vector<string> tempSymbolTableItem;
-			tempSymbolTableItem.push_back(parameterList[i].first);
-			tempSymbolTableItem.push_back(parameterList[i].second);
-			stringstream ss;
-			ss << (totalSize - 4 * i);
-			string strLocation = ss.str();
-			tempSymbolTableItem.push_back(strLocation);
-			this->symbolTable.push_back(tempSymbolTableItem);
-		}
-		// now we need to build localVars
-		int i = 0;
-		for (auto it = localVariables.begin(); it != localVariables.end(); it++) {
-			string localVarName = it->first;
-			bool param = false;
-			for (int j = 0; j < parameterList.size(); j++) {
-				if (parameterList[j].first == localVarName) {
-					param = true; break;
-				}
-			}
-			if (param) continue;
-			vector<string> tempSymbolTableItem;
-			tempSymbolTableItem.push_back(it->first);
-			tempSymbolTableItem.push_back(it->second);
-			stringstream ss;
-			ss << i;
-			string strLocation = ss.str();
-			tempSymbolTableItem.push_back(strLocation);
-			this->symbolTable.push_back(tempSymbolTableItem);
-			i = i - 4;
-		}
+void Procedure::printSymbolTable() {
+	program.comment("Symbol Table Generated");
+	for (size_t i = 0; i < declarationOrder.size(); i++) {
+		const Variable &variable = symbolTable[declarationOrder[i]];
+		string singleItem = " ";
+		singleItem = singleItem + lexemeNames[declarationOrder[i]] + "   " + typeName(variable.type) + "   " + to_string(variable.offset);
+		program.comment(singleItem);
 	}
 }
 
@@ -783,298 +740,285 @@ void Procedure::storeLocalVariableOnRAM() {
 		// set up the frame pointer
 		
 		// calculate the offset of $30
-		int sizeOfSymbolTable = symbolTable.size();
-		stringstream ss;
-		ss << sizeOfSymbolTable * 4;
-		string offset = ss.str();
-		this->mipsCodePool.push_back("lis $3");
-		string offsetWordString = ".word " + offset;
-		this->mipsCodePool.push_back(offsetWordString);
-		this->mipsCodePool.push_back("sub $30, $30, $3");
-
-		Node *firstDcl = rootNode->children[3];
-		string firstParameterName = firstDcl->children[1]->lexeme;
-		Node *secondDcl = rootNode->children[5];
-		string secondParameterName = secondDcl->children[1]->lexeme;
-		for (int i = 0; i < symbolTable.size(); i++) {
-			if (symbolTable[i][0] == firstParameterName) {
-				string location = symbolTable[i][2];
-				string storeStr = "sw $1, " + location;
-				storeStr = storeStr + "($29)";
-				this->mipsCodePool.push_back(storeStr);
-				continue;
-			}
-			if (symbolTable[i][0] == secondParameterName) {
-				string location = symbolTable[i][2];
-				string storeStr = "sw $2, " + location;
-				storeStr = storeStr + "($29)";
-				this->mipsCodePool.push_back(storeStr);
-				continue;
-			}
-		}
+		program.lis(3);
+		program.word(symbolTable.size() * 4);
+		program.sub(30, 30, 3);
+
+		// the parameters arrive in $1 and $2
+		int firstParameter = rootNode->children[3]->children[1]->lexeme;
+		int secondParameter = rootNode->children[5]->children[1]->lexeme;
+		program.sw(1, symbolTable[firstParameter].offset, 29);
+		program.sw(2, symbolTable[secondParameter].offset, 29);
 		this->generateDcls(this->rootNode->children[8]);
 	}
 	else {
 		// we need to update stack pointer
-		int NumOflocalNonParamVar = this->localVariables.size() - this->parameterList.size();
-		stringstream ss;
-		ss << NumOflocalNonParamVar * 4;
-		string offset = ss.str();
-		this->mipsCodePool.push_back("lis $3");
-		string offsetWordString = ".word " + offset;
-		this->mipsCodePool.push_back(offsetWordString);
-		this->mipsCodePool.push_back("sub $30, $30, $3");
+		int NumOflocalNonParamVar = this->symbolTable.size() - this->signature.size();
+		program.lis(3);
+		program.word(NumOflocalNonParamVar * 4);
+		program.sub(30, 30, 3);
 		// if this is a procedure other than wain
 		this->generateDcls(this->rootNode->children[6]);
 	}
 }
 Procedure::~Procedure() {};
-void Procedure::typeCheckStatements(Node *statements) {
-	if (statements->reduceRule == "statements") {
-		return;
+
+// The type checker: one walk over a procedure body that resolves every
+// identifier and call, checks the types of every statement and tags each
+// expr, term, factor and lvalue node with its type for code generation.
+// Declarations and statements are checked in source order, so the first
+// error in the body is the one reported.
+void Procedure::checkDcls(Node *dcls) {
+	vector<Node *> chain;
+	for (; dcls->numOfChildren != 0; dcls = dcls->children[0]) {
+		chain.push_back(dcls);
+	}
+	for (vector<Node *>::reverse_iterator rit = chain.rbegin(); rit != chain.rend(); rit++) {
+		processDcl((*rit)->children[1], false);
+		ValueType typeOfLvalue = typeDcl((*rit)->children[1]);
+		if ((typeOfLvalue == INT_VALUE && (*rit)->rule == WLP4::DCLS_NUM) ||
+			(typeOfLvalue == POINTER_VALUE && (*rit)->rule == WLP4::DCLS_NULL)) {
+		}
+		else {
+			throw string("ERROR: declaration type wrong");
+		}
+	}
+}
+
+void Procedure::checkStatements(Node *statements) {
+	vector<Node *> chain;
+	for (; statements->numOfChildren != 0; statements = statements->children[0]) {
+		chain.push_back(statements->children[1]);
 	}
-	else if (statements->reduceRule == "statements statements statement") {
-		typeCheckStatements(statements->children[0]);
-		typeCheckStatement(statements->children[1]);
+	for (vector<Node *>::reverse_iterator rit = chain.rbegin(); rit != chain.rend(); rit++) {
+		checkStatement(*rit);
 	}
 }
 
-void Procedure::typeCheckStatement(Node * statement) {
-	if (statement->reduceRule == "statement lvalue BECOMES expr SEMI") {
-		string typeL = typeLvalue(statement->children[0]);
-		string typeE = typeExpr(statement->children[2]);
+void Procedure::checkStatement(Node *statement) {
+	switch (statement->rule) {
+	case WLP4::STATEMENT_ASSIGN: {
+		ValueType typeL = checkLvalue(statement->children[0]);
+		ValueType typeE = checkExpr(statement->children[2]);
 		if (typeL != typeE) {
 			throw string("ERROR: a <statement lvalue BECOMES expr SEMI> statement, left right diff type");
 		}
-	}
-	if (statement->reduceRule == "statement IF LPAREN test RPAREN LBRACE statements RBRACE ELSE LBRACE statements RBRACE") {
-		Node *test = statement->children[2];
-		Node *firstStatements = statement->children[5];
-		Node *secondStatements = statement->children[9];
-		typeCheckTest(test);
-		typeCheckStatements(firstStatements);
-		typeCheckStatements(secondStatements);
-	}
-	if (statement->reduceRule == "statement WHILE LPAREN test RPAREN LBRACE statements RBRACE") {
-		Node *test = statement->children[2];
-		Node *statements = statement->children[5];
-		typeCheckTest(test);
-		typeCheckStatements(statements);
-	}
-	if (statement->reduceRule == "statement PRINTLN LPAREN expr RPAREN SEMI") {
-		string typeE = typeExpr(statement->children[2]);
-		if (typeE != "int") {
+		break;
+	}
+	case WLP4::STATEMENT_IF:
+		ifStatements++;
+		checkTest(statement->children[2]);
+		checkStatements(statement->children[5]);
+		checkStatements(statement->children[9]);
+		break;
+	case WLP4::STATEMENT_WHILE:
+		whileStatements++;
+		checkTest(statement->children[2]);
+		checkStatements(statement->children[5]);
+		break;
+	case WLP4::STATEMENT_PRINTLN:
+		if (checkExpr(statement->children[2]) != INT_VALUE) {
 			throw string("ERROR: try to print a non int");
 		}
-	}
-	if (statement->reduceRule == "statement DELETE LBRACK RBRACK expr SEMI") {
-		string typeE = typeExpr(statement->children[3]);
-		if (typeE != "int*") {
+		break;
+	case WLP4::STATEMENT_DELETE:
+		if (checkExpr(statement->children[3]) != POINTER_VALUE) {
 			throw string("ERROR: try to delete a non pointer");
 		}
+		break;
 	}
 }
 
-void Procedure::typeCheckTest(Node * test) {
-	string typeExp1 = typeExpr(test->children[0]);
-	string typeExp2 = typeExpr(test->children[2]);
+void Procedure::checkTest(Node *test) {
+	ValueType typeExp1 = checkExpr(test->children[0]);
+	ValueType typeExp2 = checkExpr(test->children[2]);
 	if (typeExp1 != typeExp2) {
 		throw string("ERROR: type diff in a test");
 	}
-	return;
 }
 
-// return a string containing the type of a expr		
-string Procedure::typeExpr(Node *expr) {
-	if (expr->reduceRule == "expr term") {
-		return typeTerm(expr->children[0]);
-	}
-	else if (expr->reduceRule == "expr expr PLUS term") {
-		string typeEx = typeExpr(expr->children[0]);
-		string typeT = typeTerm(expr->children[2]);
-		if (typeEx == "int" && typeT == "int") {
-			return "int";
-		}
-		else if ((typeEx == "int" && typeT == "int*") ||
-			(typeEx == "int*" && typeT == "int")) {
-			return "int*";
+ValueType Procedure::checkExpr(Node *expr) {
+	ValueType type = UNCHECKED;
+	switch (expr->rule) {
+	case WLP4::EXPR_TERM:
+		type = checkTerm(expr->children[0]);
+		break;
+	case WLP4::EXPR_PLUS: {
+		ValueType typeEx = checkExpr(expr->children[0]);
+		ValueType typeT = checkTerm(expr->children[2]);
+		if (typeEx == INT_VALUE && typeT == INT_VALUE) {
+			type = INT_VALUE;
+		}
+		else if (typeEx != typeT) {
+			type = POINTER_VALUE;
 		}
 		else {
 			throw string("ERROR: wrong type arround addition, maybe it's two pointer");
 		}
+		break;
 	}
-	else if (expr->reduceRule == "expr expr MINUS term") {
-		string typeEx = typeExpr(expr->children[0]);
-		string typeT = typeTerm(expr->children[2]);
-		if ((typeEx == "int" && typeT == "int") ||
-			(typeEx == "int*" && typeT == "int*")) {
-			return "int";
+	case WLP4::EXPR_MINUS: {
+		ValueType typeEx = checkExpr(expr->children[0]);
+		ValueType typeT = checkTerm(expr->children[2]);
+		if (typeEx == typeT) {
+			type = INT_VALUE;
 		}
-		else if (typeEx == "int*" && typeT == "int") {
-			return "int*";
+		else if (typeEx == POINTER_VALUE) {
+			type = POINTER_VALUE;
 		}
 		else {
 			throw string("ERROR: wrong type arround subtraction, subtract pointer from a int");
 		}
+		break;
+	}
 	}
+	return expr->valueType = type;
 }
 
-// return a string containing the type of a term	
-string Procedure::typeTerm(Node *term) {
-	if (term->reduceRule == "term factor") {
-		return typeFactor(term->children[0]);
+ValueType Procedure::checkTerm(Node *term) {
+	if (term->rule == WLP4::TERM_FACTOR) {
+		return term->valueType = checkFactor(term->children[0]);
 	}
-	else if (term->reduceRule == "term term STAR factor") {
-		string typeT = typeTerm(term->children[0]);
-		string typeF = typeFactor(term->children[2]);
-		if (typeT == "int" && typeF == "int") {
-			return "int";
-		}
-		else {
+	ValueType typeT = checkTerm(term->children[0]);
+	ValueType typeF = checkFactor(term->children[2]);
+	if (typeT != INT_VALUE || typeF != INT_VALUE) {
+		switch (term->rule) {
+		case WLP4::TERM_STAR:
 			throw string("ERROR: wrong operand type around multiple");
-		}
-	}
-	else if (term->reduceRule == "term term SLASH factor") {
-		string typeT = typeTerm(term->children[0]);
-		string typeF = typeFactor(term->children[2]);
-		if (typeT == "int" && typeF == "int") {
-			return "int";
-		}
-		else {
+		case WLP4::TERM_SLASH:
 			throw string("ERROR: wrong operand type arround slash");
-		}
-	}
-	else if (term->reduceRule == "term term PCT factor") {
-		string typeT = typeTerm(term->children[0]);
-		string typeF = typeFactor(term->children[2]);
-		if (typeT == "int" && typeF == "int") {
-			return "int";
-		}
-		else {
+		case WLP4::TERM_PCT:
 			throw string("ERROR: wrong operand type arround percentage");
 		}
 	}
+	return term->valueType = INT_VALUE;
 }
 
-// return a string containing the type of a factor	
-string Procedure::typeFactor(Node *factor) {
-	// if the id is a variable
-	if (factor->reduceRule == "factor ID") {
-		return typeID(factor->children[0]);
-	}
-	// for rule: factor -> NUM, NULL, do nothing for now
-	if (factor->reduceRule == "factor NUM") {
-		return "int";
-	}
-
-	if (factor->reduceRule == "factor NULL") {
-		return "int*";
-	}
-
-	// for rule: factor -> STAR factor
-	if (factor->reduceRule == "factor STAR factor") {
-		string typeFac = typeFactor(factor->children[1]);
-		if (typeFac == "int*") {
-			return "int";
-		}
-		else {
+ValueType Procedure::checkFactor(Node *factor) {
+	ValueType type = INT_VALUE;
+	switch (factor->rule) {
+	case WLP4::FACTOR_ID:
+		type = checkID(factor->children[0]);
+		break;
+	case WLP4::FACTOR_NUM:
+		break;
+	case WLP4::FACTOR_NULL:
+		type = POINTER_VALUE;
+		break;
+	case WLP4::FACTOR_STAR:
+		if (checkFactor(factor->children[1]) != POINTER_VALUE) {
 			throw string("ERROR: dereference on a non pointer");
 		}
-	}
-
-	// for rule: factor -> LPAREN expr RPAREN
-	if (factor->reduceRule == "factor LPAREN expr RPAREN") {
-		return typeExpr(factor->children[1]);
-	}
-
-	// for rule: factor -> AMP lvalue
-	if (factor->reduceRule == "factor AMP lvalue") {
-		string typelv = typeLvalue(factor->children[1]);
-		if (typelv == "int") {
-			return "int*";
-		}
-		else {
+		break;
+	case WLP4::FACTOR_PAREN:
+		type = checkExpr(factor->children[1]);
+		break;
+	case WLP4::FACTOR_AMP:
+		if (checkLvalue(factor->children[1]) != INT_VALUE) {
 			throw string("ERROR: reference on a non int");
 		}
-	}
-
-	// for rule: factor -> NEW INT LBRACK expr RBRACK
-	if (factor->reduceRule == "factor NEW INT LBRACK expr RBRACK") {
-		string typeEx = typeExpr(factor->children[3]);
-		if (typeEx == "int") {
-			return "int*";
-		}
-		else {
+		type = POINTER_VALUE;
+		break;
+	case WLP4::FACTOR_NEW:
+		if (checkExpr(factor->children[3]) != INT_VALUE) {
 			throw string("ERROR: try to allocate an array of a length of <non int>");
 		}
+		type = POINTER_VALUE;
+		break;
+	case WLP4::FACTOR_CALL:
+	case WLP4::FACTOR_CALL_ARGS: {
+		// we need to check if this function exists and the parameters are correct
+		string funcName = factor->children[0]->text();
+		vector<ValueType> arglist;
+		if (factor->rule == WLP4::FACTOR_CALL_ARGS) {
+			for (Node *argList = factor->children[2]; ; argList = argList->children[2]) {
+				arglist.push_back(checkExpr(argList->children[0]));
+				if (argList->numOfChildren != 3) break;
+			}
+			if (funcName == "wain") {
+				throw string("ERROR wain cannot be called within a function");
+			}
+		}
+		unordered_map<int, Procedure *>::const_iterator callee = procedureTable.find(factor->children[0]->lexeme);
+		if (callee == procedureTable.end() || callee->second->index > index) {
+			string errorMsg = "ERROR: function " + funcName;
+			errorMsg = errorMsg + " is undefined";
+			throw errorMsg;
+		}
+		const vector<ValueType> &calleeSignature = callee->second->signature;
+		if (factor->rule == WLP4::FACTOR_CALL) {
+			if (calleeSignature.size() != 0) {
+				string errorMsg = "ERROR: function " + funcName;
+				errorMsg = errorMsg + " is called with wrong number of arguments";
+				throw errorMsg;
+			}
+		}
+		else if (calleeSignature.size() != arglist.size()) {
+			string errorMsg = "ERROR: wrong number of arguments for function: ";
+			errorMsg = errorMsg + funcName;
+			throw errorMsg;
+		}
+		if (arglist != calleeSignature) {
+			// there is a argument with wrong type
+			string errorMsg = "ERROR: wrong type of arguments for function: ";
+			errorMsg = errorMsg + funcName;
+			throw errorMsg;
+		}
+		break;
 	}
-
-	// for rule: factor -> ID LPAREN RPAREN
-	if (factor->reduceRule == "factor ID LPAREN RPAREN" ||
-		factor->reduceRule == "factor ID LPAREN arglist RPAREN") {
-		// we need to check if we have this function with the same parameters
-		return "int";
 	}
+	return factor->valueType = type;
 }
 
-// return a string containing the type of a ID	
-string Procedure::typeID(Node *ID) {
-	unordered_map<string, string>::iterator itr = this->localVariables.find(ID->lexeme);
-	if (itr != localVariables.end()) {
-		string type = itr->second;
-		return type;
-	}
-	else {
-		throw string("ERROR: check type before define");
+ValueType Procedure::checkID(Node *ID) {
+	unordered_map<int, Variable>::const_iterator got = symbolTable.find(ID->lexeme);
+	if (got == symbolTable.end()) {
+		// if the variable is not found
+		string errorMsg = "ERROR: variable " + ID->text();
+		errorMsg = errorMsg + " is not defined";
+		throw errorMsg;
 	}
+	return got->second.type;
 }
 
-// return a string containing the type of a lvalue	
-string Procedure::typeLvalue(Node *lvalue) {
-	if (lvalue->reduceRule == "lvalue ID") {
-		return typeID(lvalue->children[0]);
-	}
-	else if (lvalue->reduceRule == "lvalue STAR factor") {
-		string typeF = typeFactor(lvalue->children[1]);
-		if (typeF == "int*") {
-			return "int";
-		}
-		else {
+ValueType Procedure::checkLvalue(Node *lvalue) {
+	ValueType type = INT_VALUE;
+	switch (lvalue->rule) {
+	case WLP4::LVALUE_ID:
+		type = checkID(lvalue->children[0]);
+		break;
+	case WLP4::LVALUE_STAR:
+		if (checkFactor(lvalue->children[1]) != POINTER_VALUE) {
 			throw string("ERROR: dereference on a non pointer");
 		}
+		break;
+	case WLP4::LVALUE_PAREN:
+		type = checkLvalue(lvalue->children[1]);
+		break;
 	}
-	else if (lvalue->reduceRule == "lvalue LPAREN lvalue RPAREN") {
-		return typeLvalue(lvalue->children[1]);
-	}
+	return lvalue->valueType = type;
 }
 
 //INT ID LPAREN params RPAREN LBRACE dcls statements RETURN expr SEMI RBRACE
 // main INT WAIN LPAREN dcl COMMA dcl RPAREN LBRACE dcls statements RETURN expr SEMI RBRACE
 void Procedure::processProcedure() {
 	if (this->name != "wain") {
-		processDcls(rootNode->children[6]);
-		processStatements(rootNode->children[7]);
-		processExpr(rootNode->children[9]);
-		typeCheckDCLS(rootNode->children[6]);
-		typeCheckStatements(rootNode->children[7]);
-		if ("int" != typeExpr(rootNode->children[9])) {
+		checkDcls(rootNode->children[6]);
+		checkStatements(rootNode->children[7]);
+		if (checkExpr(rootNode->children[9]) != INT_VALUE) {
 			string errMsg = "ERROR: return type of funtion ";
 			errMsg = errMsg + this->name;
 			errMsg = errMsg + "is wrong";
 			throw errMsg;
 		}
-		
 	}
 	else {
-		processDcls(rootNode->children[8]);
-		processStatements(rootNode->children[9]);
-		processExpr(rootNode->children[11]);
-		if (typeDcl(rootNode->children[5]) != "int") {
+		if (typeDcl(rootNode->children[5]) != INT_VALUE) {
 			throw string("ERROR: the second parameter of main is wrong");
 		}
-		typeCheckDCLS(rootNode->children[8]);
-		typeCheckStatements(rootNode->children[9]);
-		if ("int" != typeExpr(rootNode->children[11])) {
+		checkDcls(rootNode->children[8]);
+		checkStatements(rootNode->children[9]);
+		if (checkExpr(rootNode->children[11]) != INT_VALUE) {
 			string errMsg = "ERROR: return type of funtion wain is wrong";
 			throw errMsg;
 		}
@@ -1084,302 +1028,60 @@ void Procedure::processProcedure() {
 
 void Procedure::print() {
 	cerr << name << " ";
-	for (int i = 0; i < parameterList.size(); i++) {
-		cerr << parameterList[i].second;
-		if (i != parameterList.size() - 1) {
+	for (size_t i = 0; i < signature.size(); i++) {
+		cerr << typeName(signature[i]);
+		if (i != signature.size() - 1) {
 			cerr << " ";
 		}
 	}
 	cerr << endl;
-	for (auto it = localVariables.begin(); it != localVariables.end(); it++) {
-		cerr << it->first << " " << it->second << endl;
-	}
-	// print symbol table for test:
-	// TEST_CODE_BEGIN
-	/*cerr << "Symbol table for " << this->name << ":" << endl;
-	for (int i = 0; i < symbolTable.size(); i++) {
-		cerr << symbolTable[i][0] << " " << symbolTable[i][1] << " " << symbolTable[i][2] << endl;
-	}*/
-	// TEST_CODE_END
-}
-
-void Procedure::processLvalue(Node *lvalue) {
-	if (lvalue->reduceRule == "lvalue ID") {
-		// we need to check if the id is defined
-		unordered_map<string, string>::const_iterator got = localVariables.find(lvalue->children[0]->lexeme);
-		if (got == localVariables.end()) {
-			// if the variable is not found
-			string errorMsg = "ERROR: variable " + lvalue->children[0]->lexeme;
-			errorMsg = errorMsg + " is not defined";
-			throw errorMsg;
-		}
-		// if the id is defined, then we do other things
-	}
-	if (lvalue->reduceRule == "lvalue STAR factor") {
-		processFactor(lvalue->children[1]);
-	}
-	if (lvalue->reduceRule == "lvalue LPAREN lvalue RPAREN") {
-		processLvalue(lvalue->children[1]);
-	}
-}
-
-vector<string> Procedure::processArglist(Node *argList) {
-	vector<string> answer;
-	while (argList->numOfChildren == 3) {
-		processExpr(argList->children[0]);
-		answer.push_back(typeExpr(argList->children[0]));
-		argList = argList->children[2];
-	}
-	processExpr(argList->children[0]);
-	answer.push_back(typeExpr(argList->children[0]));
-	return answer;
-}
-
-void Procedure::processFactor(Node *factor) {
-	// if the id is a variable
-	if (factor->reduceRule == "factor ID") {
-		unordered_map<string, string>::const_iterator got = localVariables.find(factor->children[0]->lexeme);
-		if (got == localVariables.end()) {
-			// if the variable is not found
-			string errorMsg = "ERROR: variable " + factor->children[0]->lexeme;
-			errorMsg = errorMsg + " is not defined";
-			throw errorMsg;
-		}
-		// if the variable is found do nothing for now
-	}
-	// for rule: factor -> NUM, NULL, do nothing for now
-
-	// for rule: factor -> STAR factor
-	if (factor->reduceRule == "factor STAR factor") {
-		processFactor(factor->children[1]);
-		return;
-	}
-	// for rule: factor -> LPAREN expr RPAREN
-	if (factor->reduceRule == "factor LPAREN expr RPAREN") {
-		processExpr(factor->children[1]);
-		return;
-	}
-	// for rule: factor -> AMP lvalue
-	if (factor->reduceRule == "factor AMP lvalue") {
-		processLvalue(factor->children[1]);
-		return;
-	}
-	// for rule: factor -> NEW INT LBRACK expr RBRACK
-	if (factor->reduceRule == "factor NEW INT LBRACK expr RBRACK") {
-		processExpr(factor->children[3]);
-		return;
-	}
-	// for rule: factor -> ID LPAREN RPAREN
-	if (factor->reduceRule == "factor ID LPAREN RPAREN") {
-		// we need to check if we have this function with the same parameters
-		Node *ID = factor->children[0];
-		string funcName = ID->lexeme;
-		bool exist = false;
-		for (int i = 0; i < procedures.size(); i++) {
-			if (procedures[i]->name == funcName) {
-				exist = true;
-				if (procedures[i]->parameterList.size() != 0) {
-					string errorMsg = "ERROR: function " + funcName;
-					errorMsg = errorMsg + " is called with wrong number of arguments";
-					throw errorMsg;
-				}
-			}
-		}
-		if (!exist) {
-			string errorMsg = "ERROR: function " + funcName;
-			errorMsg = errorMsg + " is undefined";
-			throw errorMsg;
-		}
-		return;
-	}
-	// for rule: factor -> ID LPAREN arglist RPAREN
-	if (factor->reduceRule == "factor ID LPAREN arglist RPAREN") {
-		// we need to check if this function exists and the parameters are correct
-		Node *ID = factor->children[0];
-		Node *argList = factor->children[2];
-		// a vector of argments' types
-		vector<string> arglist = processArglist(argList);
-		string funcName = ID->lexeme;
-		if (funcName == "wain") {
-			throw string("ERROR wain cannot be called within a function");
-		}
-		bool exist = false;
-		bool typeCorrect = false;
-		for (int i = 0; i < procedures.size(); i++) {
-			if (procedures[i]->name == funcName) {
-				exist = true;
-				// get the correst argument list		
-				vector<std::pair<string, string>> &matchProcedureParameterList = procedures[i]->parameterList;
-				if (matchProcedureParameterList.size() == arglist.size()) {
-					for (int i = 0; i < arglist.size(); i++) {
-						if (arglist[i] != matchProcedureParameterList[i].second) {
-							// there is a argument with wrong type
-							string errorMsg = "ERROR: wrong type of arguments for function: ";
-							errorMsg = errorMsg + funcName;
-							throw errorMsg;
-						}
-					}
-				}
-				else {
-					string errorMsg = "ERROR: wrong number of arguments for function: ";
-					errorMsg = errorMsg + funcName;
-					throw errorMsg;
-				}
-			}
-		}
-		if (!exist) {
-			string errorMsg = "ERROR: function " + funcName;
-			errorMsg = errorMsg + " is undefined";
-			throw errorMsg;
-		}
-		return;
-	}
-}
-
-void Procedure::processTerm(Node *term) {
-	if (term->numOfChildren == 1) {
-		processFactor(term->children[0]);
-	}
-	else {
-		processTerm(term->children[0]);
-		processFactor(term->children[2]);
-	}
-}
-
-void Procedure::processExpr(Node *Expr) {
-	if (Expr->reduceRule == "expr term") {
-		processTerm(Expr->children[0]);
-	}
-	else {
-		processExpr(Expr->children[0]);
-		processTerm(Expr->children[2]);
-	}
-}
-
-void Procedure::processTest(Node *test) {
-	processExpr(test->children[0]);
-	processExpr(test->children[2]);
-}
-
-void Procedure::processStatement(Node *statement) {
-	if (statement->reduceRule == "statement lvalue BECOMES expr SEMI") {
-		Node *lvalue = statement->children[0];
-		Node *expr = statement->children[2];
-		processLvalue(lvalue);
-		processExpr(expr);
-	}
-	if (statement->reduceRule == "statement IF LPAREN test RPAREN LBRACE statements RBRACE ELSE LBRACE statements RBRACE") {
-		Node *test = statement->children[2];
-		Node *firstStatements = statement->children[5];
-		Node *secondStatements = statement->children[9];
-		processTest(test);
-		processStatements(firstStatements);
-		processStatements(secondStatements);
-	}
-	if (statement->reduceRule == "statement WHILE LPAREN test RPAREN LBRACE statements RBRACE") {
-		Node *test = statement->children[2];
-		Node *statements = statement->children[5];
-		processTest(test);
-		processStatements(statements);
-	}
-	if (statement->reduceRule == "statement PRINTLN LPAREN expr RPAREN SEMI") {
-		Node *expr = statement->children[2];
-		processExpr(expr);
-	}
-	if (statement->reduceRule == "statement DELETE LBRACK RBRACK expr SEMI") {
-		Node *expr = statement->children[3];
-		processExpr(expr);
+	for (size_t i = 0; i < declarationOrder.size(); i++) {
+		const Variable &variable = symbolTable[declarationOrder[i]];
+		cerr << lexemeNames[declarationOrder[i]] << " " << typeName(variable.type) << " " << variable.offset << endl;
 	}
 }
 
-void Procedure::processStatements(Node *statements) {
-	while (statements->numOfChildren != 0) {
-		processStatement(statements->children[1]);
-		statements = statements->children[0];
-	}
-	return;
-}
-
 void Procedure::generateDcls(Node *dcls) {
 	while (dcls->numOfChildren != 0) {
-		string typeOfRvalue = dcls->children[3]->type;
-		string nameOfVar = dcls->children[1]->children[1]->lexeme;
-		string location = "";
-		for (int i = 0; i < symbolTable.size(); i++) {
-			if (symbolTable[i][0] == nameOfVar) location = symbolTable[i][2];
-		}
-		if (typeOfRvalue == "NUM") {
+		int location = symbolTable[dcls->children[1]->children[1]->lexeme].offset;
+		if (dcls->rule == WLP4::DCLS_NUM) {
 			//process number declaration
-			string numStr = dcls->children[3]->lexeme;
 			// load the value of this dcl to $3
-			this->mipsCodePool.push_back("lis $3");
-			string wordStr = ".word " + numStr;
-			this->mipsCodePool.push_back(wordStr);
+			program.lis(3);
+			program.word(numValue(dcls->children[3]));
 		}
-		else if(typeOfRvalue == "NULL"){
+		else if(dcls->rule == WLP4::DCLS_NULL){
 			//process NULL declaration
-			this->mipsCodePool.push_back("add $3, $0, $11");
-		}
-		string saveOnRAMStr = "sw $3, ";
-		saveOnRAMStr = saveOnRAMStr + location;
-		saveOnRAMStr = saveOnRAMStr + "($29)";
-		this->mipsCodePool.push_back(saveOnRAMStr);
-		dcls = dcls->children[0];
-	}
-	return;
-}
-void Procedure::processDcls(Node *dcls) {
-	while (dcls->numOfChildren != 0) {
-		this->processDcl(dcls->children[1], false);
-		dcls = dcls->children[0];
-	}
-	return;
-}
-
-void Procedure::typeCheckDCLS(Node * dcls) {
-	while (dcls->numOfChildren != 0) {
-		string typeOfRvalue = dcls->children[3]->type;
-		string typeOfLvalue = typeDcl(dcls->children[1]);
-		if ((typeOfLvalue == "int" && typeOfRvalue == "NUM") ||
-			(typeOfLvalue == "int*" && typeOfRvalue == "NULL")) {
-		}
-		else {
-			throw string("ERROR: declaration type wrong");
+			program.add(3, 0, 11);
 		}
+		program.sw(3, location, 29);
 		dcls = dcls->children[0];
 	}
 	return;
 }
 
-string Procedure::typeDcl(Node *dcl) {
+ValueType Procedure::typeDcl(Node *dcl) {
 	Node * type = dcl->children[0];
-	return type->numOfChildren == 1 ? "int" : "int*";
+	return type->numOfChildren == 1 ? INT_VALUE : POINTER_VALUE;
 }
 
+// Enters a declaration into the symbol table. wain keeps its parameters
+// in its frame with the locals, at 0, -4, -8, ... from $29; any other
+// procedure finds its parameters above $29 where the caller pushed them
+// (see Procedure's constructor).
 void Procedure::processDcl(Node * dcl, bool param) {
-	Node * type = dcl->children[0];
-	Node *ID = dcl->children[1];
-	string typeString;
-	if (type->reduceRule == "type INT STAR") {
-		typeString = "int*";
-	}
-	else {
-		typeString = "int";
-	}
-	string idString = ID->lexeme;
-	if (localVariables.find(idString) != localVariables.end()) {
+	int id = dcl->children[1]->lexeme;
+	if (symbolTable.find(id) != symbolTable.end()) {
 		string error = "ERROR parameter redefined in function:" + this->name;
 		throw error;
 	}
-	//if (this->parameterList[i].first == typeString &&
-	//	this->parameterList[i].second == idString) {
-	//	string error = "ERROR parameter redefined in function:" + this->name;
-	//	throw error;
-	//}
+	ValueType type = typeDcl(dcl);
 	if (param) {
-		this->parameterList.push_back(std::make_pair(idString, typeString));
+		this->signature.push_back(type);
 	}
-	localVariables[idString] = typeString;
+	int frameSlots = this->name == "wain" ? symbolTable.size() : symbolTable.size() - signature.size();
+	symbolTable[id] = Variable{ type, -4 * frameSlots };
+	declarationOrder.push_back(id);
 }
 
 void Procedure::processParamlist(Node *paramlist) {
@@ -1402,21 +1104,23 @@ void Procedure::processParams(Node *params) {
 	}
 }
 
-Procedure::Procedure(Node *rootNode, vector<Procedure *>&procedures, vector<string> &mipsCodePool) : rootNode{ rootNode }, procedures{ procedures }, returnType{ "int" }, 
-name{ rootNode->children[1]->lexeme }, mipsCodePool{ mipsCodePool } {
-	localVariables = unordered_map<string, string>();
-	parameterList = vector<std::pair<string, string>>();
+Procedure::Procedure(Node *rootNode, int index, unordered_map<int, Procedure *> &procedureTable, MIPS::Program &linked) : rootNode{ rootNode }, procedureTable{ procedureTable }, returnType{ "int" }, 
+name{ rootNode->children[1]->text() }, index{ index }, entryLabel{ -1 }, ifCount{ 0 }, whileCount{ 0 }, ifStatements{ 0 }, whileStatements{ 0 } {
 	// if this procedure is a "procedure"
-	for (int i = 0; i < procedures.size(); i++) {
-		if (procedures[i]->name == name) {
-			string errorMsg = "ERROR: function " + name;
-			errorMsg = errorMsg + " is already defined";
-			throw errorMsg;
-		}
+	if (procedureTable.find(rootNode->children[1]->lexeme) != procedureTable.end()) {
+		string errorMsg = "ERROR: function " + name;
+		errorMsg = errorMsg + " is already defined";
+		throw errorMsg;
 	}
 	if (name != "wain") {
 		Node *params = rootNode->children[3];
 		processParams(params);
+		// the caller pushes the arguments in order, so the last one is
+		// nearest the frame
+		for (size_t i = 0; i < signature.size(); i++) {
+			symbolTable[declarationOrder[i]].offset = 4 * static_cast<int>(signature.size() - i);
+		}
+		entryLabel = linked.newLabel("F" + name);
 		return;
 	}
 	else {
@@ -1429,32 +1133,66 @@ name{ rootNode->children[1]->lexeme }, mipsCodePool{ mipsCodePool } {
 }
 
 
-int ConstructionStack::ifCount = 0;
-int ConstructionStack::whileCount = 0;
-
-void ConstructionStack::outputMips() {
-	//cerr << "Mips code generated:" << endl;
-	for (int i = 0; i < mipsCodePool.size(); i++) {
-		cout << mipsCodePool[i] << endl;
+void ConstructionStack::outputMips(bool assembly) {
+	if (assembly) {
+		program.writeAssembly(cout);
+	}
+	else {
+		program.writeMerl(cout);
 	}
 }
 
-void ConstructionStack::findProcedures(Node * startNode) {
-	mipsCodePool.push_back(".import print");
-	mipsCodePool.push_back(".import new");
-	mipsCodePool.push_back(".import delete");
-	mipsCodePool.push_back(".import init");
-	Node * proceduresNode = startNode->children[1];
-	while (proceduresNode->numOfChildren == 2) {
-		procedures.push_back(new Procedure{ proceduresNode->children[0] , this->procedures , this->mipsCodePool});
-		procedures.back()->processProcedure();
-		proceduresNode = proceduresNode->children[1];
-	}
-	main = new Procedure{ proceduresNode->children[0] , this->procedures, this->mipsCodePool };
-	main->processProcedure();
-	main->generateCode();
-	for (int i = 0; i < this->procedures.size(); i++) {
-		this->procedures[i]->generateCode();
+// Checks and generates the procedures on up to jobs threads. Their
+// signatures are collected first, in order; after that each body only
+// needs the signatures, so the bodies are checked, and then generated,
+// independently. The first error in the source is the one reported, as
+// when each procedure was checked before the next was declared.
+void ConstructionStack::findProcedures(Node * startNode, unsigned jobs) {
+	for (int i = 0; i < NUM_RUNTIME_LABELS; i++) {
+		program.import(program.newLabel(runtimeNames[i]));
+	}
+	// The procedures in source order, main last, up to the first one
+	// whose declaration is wrong
+	vector<Procedure *> declared;
+	std::exception_ptr declarationError;
+	try {
+		Node * proceduresNode = startNode->children[1];
+		while (proceduresNode->numOfChildren == 2) {
+			procedures.push_back(new Procedure{ proceduresNode->children[0] , (int)procedures.size(), this->procedureTable , this->program});
+			procedureTable[proceduresNode->children[0]->children[1]->lexeme] = procedures.back();
+			declared.push_back(procedures.back());
+			proceduresNode = proceduresNode->children[1];
+		}
+		main = new Procedure{ proceduresNode->children[0] , (int)procedures.size(), this->procedureTable, this->program };
+		declared.push_back(main);
+	}
+	catch (const string &) {
+		declarationError = std::current_exception();
+	}
+	runInParallel(declared.size(), jobs, [&](size_t i) {
+		declared[i]->processProcedure();
+	});
+	if (declarationError) std::rethrow_exception(declarationError);
+
+	// Code comes out main first. Number each procedure's labels after
+	// those of the procedures before it.
+	vector<Procedure *> order(1, main);
+	order.insert(order.end(), procedures.begin(), procedures.end());
+	int ifs = 0, whiles = 0, labels = program.labelCount();
+	for (size_t i = 0; i < order.size(); i++) {
+		order[i]->ifCount = ifs;
+		order[i]->whileCount = whiles;
+		order[i]->program = MIPS::Program(labels);
+		ifs += order[i]->ifStatements;
+		whiles += order[i]->whileStatements;
+		labels += 2 * (order[i]->ifStatements + order[i]->whileStatements);
+	}
+	runInParallel(order.size(), jobs, [&](size_t i) {
+		order[i]->generateCode();
+	});
+	for (size_t i = 0; i < order.size(); i++) {
+		program.append(order[i]->program);
+		order[i]->program = MIPS::Program();
 	}
 }
 
@@ -1466,17 +1204,14 @@ void ConstructionStack::printProcedures() {
 	this->main->print();
 }
 
-void ConstructionStack::analyzeNodeAfterConstruct() {
+void ConstructionStack::analyzeNodeAfterConstruct(unsigned jobs) {
 	for (int i = 0; i < nodeStack.size(); i++) {
-		findProcedures(nodeStack[i]);
+		findProcedures(nodeStack[i], jobs);
 	}
 	//printProcedures();
 }
 
 ConstructionStack::~ConstructionStack() {
-	for (vector<Node *>::iterator it = nodeStack.begin(); it != nodeStack.end(); it++) {
-		delete *it;
-	}
 	//vector<Procedure *> procedures;
 	for (vector<Procedure *>::iterator it = procedures.begin(); it != procedures.end(); it++) {
 		delete *it;
@@ -1493,40 +1228,151 @@ void ConstructionStack::print() {
 void ConstructionStack::putOnNode(Node * node) {
 	int sizeOfStack = this->nodeStack.size();
 	int numOfChildNode = node->numOfChildren;
-	if (sizeOfStack == 0 || numOfChildNode == 0) {
+	if (numOfChildNode == 0) {
 		this->nodeStack.push_back(node);
 		return;
 	}
+	if (sizeOfStack < numOfChildNode) {
+		throw string("ERROR: malformed derivation");
+	}
 	vector<Node *>::reverse_iterator rbg = this->nodeStack.rbegin();
-	for (vector<Node *>::reverse_iterator rit = rbg; rit < rbg + numOfChildNode; rit++) {
-		node->addChild(*rit);
+	for (int i = 0; i < numOfChildNode; i++) {
+		node->children[i] = rbg[i];
 	}
 	for (int i = numOfChildNode; i >= 1; i--) {
 		this->nodeStack.pop_back();
 	}
 	nodeStack.push_back(node);
 }
-int main()
+// Builds the tree of a binary derivation (see wlp4binary.h) onto the
+// construction stack. Preorder lists each node before its children, so
+// a stack of the nodes still waiting for children is all that is needed.
+void readBinaryDerivation(const string &data, ConstructionStack *stack) {
+	const string malformed = "ERROR: malformed derivation";
+	const char *p = data.data();
+	const char *end = p + data.size();
+	if (end - p < (ptrdiff_t)sizeof WLP4::derivationMagic || !equal(p, p + sizeof WLP4::derivationMagic, WLP4::derivationMagic)) {
+		throw malformed;
+	}
+	p += sizeof WLP4::derivationMagic;
+	// The nodes still waiting for children, with how many they have
+	vector<pair<Node *, int>> open;
+	while (p != end) {
+		unsigned char record = *p++;
+		Node *node;
+		if (record & WLP4::LEAF) {
+			unsigned symbol = record & ~WLP4::LEAF;
+			if (symbol >= WLP4::NUM_SYMBOLS) throw malformed;
+			if (WLP4::fixedSpelling(symbol)) {
+				node = Node::make(stack->arena, (int)symbol, WLP4::terminalSpellings[symbol]);
+			}
+			else {
+				uint32_t length;
+				p = WLP4::decodeVarint(p, end, length);
+				if (!p || (uint32_t)(end - p) < length) throw malformed;
+				node = Node::make(stack->arena, (int)symbol, string(p, length));
+				p += length;
+			}
+		}
+		else {
+			if (record >= WLP4::NUM_RULES) throw malformed;
+			node = Node::make(stack->arena, (int)record);
+		}
+		if (open.empty()) {
+			stack->nodeStack.push_back(node);
+		}
+		else {
+			open.back().first->children[open.back().second++] = node;
+			if (open.back().second == open.back().first->numOfChildren) open.pop_back();
+		}
+		if (node->numOfChildren > 0) open.push_back(make_pair(node, 0));
+	}
+	if (!open.empty()) throw malformed;
+}
+
+// Builds the tree of a text derivation onto the construction stack. It
+// lists the nodes in preorder, so read backwards each node comes after
+// all of its children and finds them on top of the stack.
+void readTextDerivation(const string &data, ConstructionStack *stack) {
+	const char *begin = data.data();
+	const char *end = begin + data.size();
+	if (begin == end) return;
+	// Lines as getline reads them: a newline ends a line, and anything
+	// after the last newline is one more
+	if (end[-1] == '\n') --end;
+	for (;;) {
+		const char *line = end;
+		while (line != begin && line[-1] != '\n') --line;
+		stack->putOnNode(Node::make(stack->arena, string(line, end)));
+		if (line == begin) return;
+		end = line - 1;
+	}
+}
+
+// The N of -j N, a non-negative integer; 0 means one thread per core
+static unsigned jobCount(const char *arg) {
+	char *end;
+	errno = 0;
+	unsigned long n = strtoul(arg, &end, 10);
+	if (*arg < '0' || *arg > '9' || *end != '\0' || errno == ERANGE || n > UINT_MAX) {
+		throw string("ERROR: -j takes a non-negative integer, not ") + arg;
+	}
+	if (n == 0) return std::max(1u, std::thread::hardware_concurrency());
+	return n;
+}
+
+int main(int argc, char *argv[])
 {
+	// -asm writes assembly text, for reading, instead of a MERL module.
+	// -j N checks and generates the procedures with N threads (0 for one
+	// per core); the output is the same for every N.
+	bool assembly = false;
+	unsigned jobs = 1;
+	try {
+		for (int i = 1; i < argc; i++) {
+			string arg = argv[i];
+			if (arg == "-asm") assembly = true;
+			else if (arg == "-j") {
+				if (i + 1 == argc) throw string("ERROR: -j takes a number of threads");
+				jobs = jobCount(argv[++i]);
+			}
+			else if (arg[0] == '-') throw "ERROR: unknown option " + arg;
+			else throw "ERROR: unexpected argument " + arg + ", the input is read from stdin";
+		}
+	}
+	catch (string e) {
+		cerr << e << endl;
+		return 0;
+	}
 	ConstructionStack * stack = new ConstructionStack();
-	string line;
-	vector<string> inputRules;
-	// first try to get reversed input 
-	while (getline(cin, line)) {
-		inputRules.push_back(line);
+	string data;
+	char chunk[65536];
+	while (cin.read(chunk, sizeof chunk) || cin.gcount() > 0) {
+		data.append(chunk, cin.gcount());
 	}
-	for (vector<string>::reverse_iterator rit = inputRules.rbegin(); rit != inputRules.rend(); rit++) {
-		Node *temp = new Node{ *rit };
-		stack->putOnNode(temp);
+	try {
+		// wlp4parse -b output is told apart from text by its first byte
+		if (!data.empty() && data[0] == WLP4::derivationMagic[0]) {
+			readBinaryDerivation(data, stack);
+		}
+		else {
+			readTextDerivation(data, stack);
+		}
+	}
+	catch (string e) {
+		cerr << e << endl;
+		delete stack;
+		return 0;
 	}
+	string().swap(data);
 	//stack->print();
 	// for(int  i = 0; i < stack->nodeStack.size(); i++){
 	// 	cout << stack->nodeStack[i]->type<<endl;
 	// }
 	//stack->nodeStack[stack->nodeStack.size()  -1]->print();
 	try {
-		stack->analyzeNodeAfterConstruct();
-		stack->outputMips();
+		stack->analyzeNodeAfterConstruct(jobs);
+		stack->outputMips(assembly);
 	}
 	catch (string e) {
 		cerr << e << endl;
@@ -0,0 +1,210 @@
+#ifndef __WLP4GRAMMAR_H__
+#define __WLP4GRAMMAR_H__
+
+// The symbols and productions of the wlp4 grammar, shared by the tools
+// of the pipeline so that they agree on a numbering
+namespace WLP4 {
+	enum Terminal {
+		AMP,
+		BECOMES,
+		BOF,
+		COMMA,
+		DELETE,
+		ELSE,
+		EOF_,       // EOF is taken by <cstdio>
+		EQ,
+		GE,
+		GT,
+		ID,
+		IF,
+		INT,
+		LBRACE,
+		LBRACK,
+		LE,
+		LPAREN,
+		LT,
+		MINUS,
+		NE,
+		NEW,
+		NULL_,      // NULL is taken by <cstddef>
+		NUM,
+		PCT,
+		PLUS,
+		PRINTLN,
+		RBRACE,
+		RBRACK,
+		RETURN,
+		RPAREN,
+		SEMI,
+		SLASH,
+		STAR,
+		WAIN,
+		WHILE,
+		NUM_TERMINALS
+	};
+
+	// The nonterminals are numbered after the terminals, so that one
+	// id space covers every grammar symbol. They are spelled as in the
+	// grammar.
+	enum NonTerminal {
+		start = NUM_TERMINALS,
+		dcl,
+		dcls,
+		expr,
+		factor,
+		lvalue,
+		procedure,
+		procedures,
+		main,
+		params,
+		paramlist,
+		statement,
+		statements,
+		term,
+		test,
+		type,
+		arglist,
+		NUM_SYMBOLS
+	};
+	const int NUM_NONTERMINALS = NUM_SYMBOLS - NUM_TERMINALS;
+
+	// The name of each symbol as it appears in the grammar
+	constexpr const char *symbolNames[NUM_SYMBOLS] = {
+		"AMP", "BECOMES", "BOF", "COMMA", "DELETE", "ELSE", "EOF", "EQ", "GE",
+		"GT", "ID", "IF", "INT", "LBRACE", "LBRACK", "LE", "LPAREN", "LT",
+		"MINUS", "NE", "NEW", "NULL", "NUM", "PCT", "PLUS", "PRINTLN",
+		"RBRACE", "RBRACK", "RETURN", "RPAREN", "SEMI", "SLASH", "STAR",
+		"WAIN", "WHILE",
+		"start", "dcl", "dcls", "expr", "factor", "lvalue", "procedure",
+		"procedures", "main", "params", "paramlist", "statement",
+		"statements", "term", "test", "type", "arglist"
+	};
+
+	// A production lhs -> rhs[0] .. rhs[length - 1]
+	const int MAX_RHS = 14;
+	struct Rule {
+		unsigned char lhs;
+		unsigned char length;
+		unsigned char rhs[MAX_RHS];
+	};
+
+	// The productions of the grammar by name, in the numbering the LR
+	// automaton uses. Each is named for its lhs and what tells it apart
+	// from the other productions of that lhs.
+	enum Production {
+		START,
+		PROCEDURES_PROCEDURE,
+		PROCEDURES_MAIN,
+		PROCEDURE,
+		MAIN,
+		PARAMS_EMPTY,
+		PARAMS_PARAMLIST,
+		PARAMLIST_DCL,
+		PARAMLIST_DCL_COMMA,
+		TYPE_INT,
+		TYPE_INT_STAR,
+		DCLS_EMPTY,
+		DCLS_NUM,
+		DCLS_NULL,
+		DCL,
+		STATEMENTS_EMPTY,
+		STATEMENTS_STATEMENT,
+		STATEMENT_ASSIGN,
+		STATEMENT_IF,
+		STATEMENT_WHILE,
+		STATEMENT_PRINTLN,
+		STATEMENT_DELETE,
+		TEST_EQ,
+		TEST_NE,
+		TEST_LT,
+		TEST_LE,
+		TEST_GE,
+		TEST_GT,
+		EXPR_TERM,
+		EXPR_PLUS,
+		EXPR_MINUS,
+		TERM_FACTOR,
+		TERM_STAR,
+		TERM_SLASH,
+		TERM_PCT,
+		FACTOR_ID,
+		FACTOR_NUM,
+		FACTOR_NULL,
+		FACTOR_PAREN,
+		FACTOR_AMP,
+		FACTOR_STAR,
+		FACTOR_NEW,
+		FACTOR_CALL,
+		FACTOR_CALL_ARGS,
+		ARGLIST_EXPR,
+		ARGLIST_EXPR_COMMA,
+		LVALUE_ID,
+		LVALUE_STAR,
+		LVALUE_PAREN,
+		NUM_RULES
+	};
+
+	// The productions of the grammar
+	constexpr Rule rules[NUM_RULES] = {
+		{ start, 3, { BOF, procedures, EOF_ } },
+		{ procedures, 2, { procedure, procedures } },
+		{ procedures, 1, { main } },
+		{ procedure, 12, { INT, ID, LPAREN, params, RPAREN, LBRACE, dcls, statements, RETURN, expr, SEMI, RBRACE } },
+		{ main, 14, { INT, WAIN, LPAREN, dcl, COMMA, dcl, RPAREN, LBRACE, dcls, statements, RETURN, expr, SEMI, RBRACE } },
+		{ params, 0, {} },
+		{ params, 1, { paramlist } },
+		{ paramlist, 1, { dcl } },
+		{ paramlist, 3, { dcl, COMMA, paramlist } },
+		{ type, 1, { INT } },
+		{ type, 2, { INT, STAR } },
+		{ dcls, 0, {} },
+		{ dcls, 5, { dcls, dcl, BECOMES, NUM, SEMI } },
+		{ dcls, 5, { dcls, dcl, BECOMES, NULL_, SEMI } },
+		{ dcl, 2, { type, ID } },
+		{ statements, 0, {} },
+		{ statements, 2, { statements, statement } },
+		{ statement, 4, { lvalue, BECOMES, expr, SEMI } },
+		{ statement, 11, { IF, LPAREN, test, RPAREN, LBRACE, statements, RBRACE, ELSE, LBRACE, statements, RBRACE } },
+		{ statement, 7, { WHILE, LPAREN, test, RPAREN, LBRACE, statements, RBRACE } },
+		{ statement, 5, { PRINTLN, LPAREN, expr, RPAREN, SEMI } },
+		{ statement, 5, { DELETE, LBRACK, RBRACK, expr, SEMI } },
+		{ test, 3, { expr, EQ, expr } },
+		{ test, 3, { expr, NE, expr } },
+		{ test, 3, { expr, LT, expr } },
+		{ test, 3, { expr, LE, expr } },
+		{ test, 3, { expr, GE, expr } },
+		{ test, 3, { expr, GT, expr } },
+		{ expr, 1, { term } },
+		{ expr, 3, { expr, PLUS, term } },
+		{ expr, 3, { expr, MINUS, term } },
+		{ term, 1, { factor } },
+		{ term, 3, { term, STAR, factor } },
+		{ term, 3, { term, SLASH, factor } },
+		{ term, 3, { term, PCT, factor } },
+		{ factor, 1, { ID } },
+		{ factor, 1, { NUM } },
+		{ factor, 1, { NULL_ } },
+		{ factor, 3, { LPAREN, expr, RPAREN } },
+		{ factor, 2, { AMP, lvalue } },
+		{ factor, 2, { STAR, factor } },
+		{ factor, 5, { NEW, INT, LBRACK, expr, RBRACK } },
+		{ factor, 3, { ID, LPAREN, RPAREN } },
+		{ factor, 4, { ID, LPAREN, arglist, RPAREN } },
+		{ arglist, 1, { expr } },
+		{ arglist, 3, { expr, COMMA, arglist } },
+		{ lvalue, 1, { ID } },
+		{ lvalue, 2, { STAR, factor } },
+		{ lvalue, 3, { LPAREN, lvalue, RPAREN } }
+	};
+
+	// The lexeme of every terminal that can only be spelled one way;
+	// ID and NUM are null
+	const char *const terminalSpellings[NUM_TERMINALS] = {
+		"&", "=", "BOF", ",", "delete", "else", "EOF", "==", ">=",
+		">", nullptr, "if", "int", "{", "[", "<=", "(", "<",
+		"-", "!=", "new", "NULL", nullptr, "%", "+", "println",
+		"}", "]", "return", ")", ";", "/", "*",
+		"wain", "while"
+	};
+}
+#endif
@@ -3,196 +3,249 @@
 #include <sstream>
 #include <algorithm>
 #include <string>
-#include <unordered_map>
+#include <cstdint>
+#include <cstdlib>
+#include <cerrno>
+#include <climits>
+#include <cctype>
+#include <cstring>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <exception>
+#include "arena.h"
+#include "wlp4binary.h"
+#include "wlp4tables.h"
 using std::string;
 using std::istream;
 using std::ostream;
 using namespace std;
 
 
-string machine = "72 RPAREN reduce 45 112 paramlist shift 1 85 LPAREN shift 2 40 factor shift 3 3 EQ reduce 47 74 EQ reduce 46 21 INT shift 4 100 EQ reduce 48 106 STAR shift 5 86 STAR shift 5 88 STAR shift 5 95 SEMI shift 6 51 SEMI shift 7 118 NULL shift 8 128 STAR reduce 11 2 NULL shift 8 108 GT shift 9 57 RETURN reduce 16 6 INT reduce 13 7 INT reduce 12 19 factor shift 10 71 factor shift 10 14 term shift 11 44 term shift 11 17 term shift 11 25 term shift 11 13 term shift 11 9 term shift 11 117 BECOMES reduce 14 94 LPAREN reduce 11 100 GT reduce 48 3 GT reduce 47 74 GT reduce 46 85 expr shift 12 108 GE shift 13 74 GE reduce 46 3 GE reduce 47 100 GE reduce 48 128 PRINTLN reduce 11 108 EQ shift 14 2 STAR shift 5 118 STAR shift 5 106 NEW shift 15 86 NEW shift 15 88 NEW shift 15 123 RPAREN shift 16 108 LT shift 17 23 procedure shift 18 70 term shift 11 31 PLUS shift 19 32 PLUS shift 19 33 PLUS shift 19 34 PLUS shift 19 35 PLUS shift 19 36 PLUS shift 19 94 WHILE reduce 11 29 COMMA shift 20 94 dcls shift 21 70 ID shift 22 0 BOF shift 23 5 NULL shift 8 56 LPAREN shift 24 108 LE shift 25 101 COMMA shift 26 121 SEMI shift 27 83 DELETE reduce 18 59 RETURN reduce 15 57 WHILE reduce 16 18 main shift 28 82 DELETE reduce 19 127 STAR reduce 39 102 STAR reduce 40 74 LE reduce 46 30 STAR reduce 36 8 STAR reduce 37 112 dcl shift 29 90 STAR reduce 43 93 STAR reduce 42 97 STAR reduce 38 116 STAR reduce 41 73 NUM shift 30 14 expr shift 31 44 expr shift 32 17 expr shift 33 25 expr shift 34 13 expr shift 35 9 expr shift 36 37 EOF reduce 4 87 RBRACE shift 37 26 INT shift 4 24 INT shift 4 5 STAR shift 5 59 STAR reduce 15 130 DELETE reduce 17 68 DELETE reduce 20 131 DELETE reduce 21 59 WHILE reduce 15 11 LT reduce 28 61 LT reduce 30 60 LT reduce 29 129 LPAREN shift 38 121 PLUS shift 19 46 NEW shift 15 52 NEW shift 15 66 NEW shift 15 4 ID reduce 9 38 LPAREN shift 38 85 STAR shift 5 18 procedures shift 39 85 NUM shift 30 40 NULL shift 8 61 RPAREN reduce 30 60 RPAREN reduce 29 11 RPAREN reduce 28 59 ID reduce 15 59 IF reduce 15 57 RBRACE reduce 16 61 NE reduce 30 60 NE reduce 29 11 NE reduce 28 77 IF reduce 15 76 IF reduce 15 115 STAR shift 40 78 ID reduce 15 78 IF reduce 15 74 RBRACK reduce 46 3 RBRACK reduce 47 100 RBRACK reduce 48 128 LPAREN reduce 11 77 ID reduce 15 76 ID reduce 15 15 INT shift 41 113 STAR shift 40 114 STAR shift 40 20 type shift 42 22 RPAREN reduce 35 24 type shift 42 26 type shift 42 129 WHILE shift 43 108 NE shift 44 11 LE reduce 28 70 factor shift 10 105 NEW shift 15 104 NEW shift 15 80 term shift 11 80 expr shift 12 113 LPAREN shift 38 114 LPAREN shift 38 117 RPAREN reduce 14 115 LPAREN shift 38 61 LE reduce 30 60 LE reduce 29 63 BECOMES shift 45 90 PCT reduce 43 116 PCT reduce 41 30 PCT reduce 36 8 PCT reduce 37 127 PCT reduce 39 102 PCT reduce 40 93 PCT reduce 42 97 PCT reduce 38 47 MINUS reduce 32 48 MINUS reduce 33 49 MINUS reduce 34 10 MINUS reduce 31 10 STAR reduce 31 11 STAR shift 46 61 STAR shift 46 60 STAR shift 46 70 LPAREN shift 2 46 factor shift 47 52 factor shift 48 66 factor shift 49 14 STAR shift 5 44 STAR shift 5 17 STAR shift 5 25 STAR shift 5 13 STAR shift 5 9 STAR shift 5 80 arglist shift 50 12 RPAREN reduce 44 19 NEW shift 15 71 NEW shift 15 45 NUM shift 51 61 GE reduce 30 60 GE reduce 29 11 GE reduce 28 10 RBRACK reduce 31 47 RBRACK reduce 32 48 RBRACK reduce 33 49 RBRACK reduce 34 90 COMMA reduce 43 116 COMMA reduce 41 61 GT reduce 30 60 GT reduce 29 11 SLASH shift 52 11 GT reduce 28 61 SLASH shift 52 60 SLASH shift 52 30 COMMA reduce 36 8 COMMA reduce 37 127 COMMA reduce 39 102 COMMA reduce 40 47 STAR reduce 32 48 STAR reduce 33 49 STAR reduce 34 80 ID shift 22 93 COMMA reduce 42 97 COMMA reduce 38 70 NULL shift 8 59 RBRACE reduce 15 46 AMP shift 53 52 AMP shift 53 66 AMP shift 53 23 main shift 28 94 ID reduce 11 78 RBRACE reduce 15 94 IF reduce 11 94 PRINTLN reduce 11 23 INT shift 54 5 ID shift 22 46 STAR shift 5 52 STAR shift 5 66 STAR shift 5 113 DELETE shift 55 114 DELETE shift 55 116 SLASH reduce 41 129 STAR shift 40 90 SLASH reduce 43 112 RPAREN reduce 5 54 WAIN shift 56 127 SLASH reduce 39 102 SLASH reduce 40 93 SLASH reduce 42 97 SLASH reduce 38 30 SLASH reduce 36 8 SLASH reduce 37 19 STAR shift 5 71 STAR shift 5 118 NUM shift 30 109 statement shift 57 2 NUM shift 30 73 LPAREN shift 2 53 LPAREN shift 38 47 COMMA reduce 32 48 COMMA reduce 33 49 COMMA reduce 34 14 factor shift 10 44 factor shift 10 17 factor shift 10 25 factor shift 10 13 factor shift 10 9 factor shift 10 10 COMMA reduce 31 100 STAR reduce 48 3 STAR reduce 47 74 STAR reduce 46 115 DELETE shift 55 109 PRINTLN shift 58 78 WHILE reduce 15 77 RBRACE reduce 15 76 RBRACE reduce 15 113 statement shift 57 114 statement shift 57 22 PLUS reduce 35 115 statement shift 57 105 AMP shift 53 104 AMP shift 53 77 WHILE reduce 15 76 WHILE reduce 15 128 dcls shift 59 118 term shift 11 2 term shift 11 19 term shift 60 71 term shift 61 128 WHILE reduce 11 19 LPAREN shift 2 71 LPAREN shift 2 128 RETURN reduce 11 57 ID reduce 16 57 IF reduce 16 23 procedures shift 62 2 LPAREN shift 2 118 LPAREN shift 2 21 dcl shift 63 19 NULL shift 8 71 NULL shift 8 78 PRINTLN reduce 15 77 PRINTLN reduce 15 76 PRINTLN reduce 15 2 expr shift 64 118 expr shift 65 11 PCT shift 66 21 ID reduce 15 21 IF reduce 15 6 LPAREN reduce 13 7 LPAREN reduce 12 113 lvalue shift 67 114 lvalue shift 67 14 NULL shift 8 44 NULL shift 8 17 NULL shift 8 25 NULL shift 8 13 NULL shift 8 9 NULL shift 8 118 AMP shift 53 115 lvalue shift 67 2 AMP shift 53 16 SEMI shift 68 80 factor shift 10 94 INT reduce 11 5 NEW shift 15 73 STAR shift 5 57 PRINTLN reduce 16 80 NEW shift 15 74 LT reduce 46 3 LT reduce 47 46 NUM shift 30 52 NUM shift 30 66 NUM shift 30 10 PCT reduce 31 3 LE reduce 47 100 LE reduce 48 85 NEW shift 15 21 WHILE reduce 15 47 PCT reduce 32 48 PCT reduce 33 49 PCT reduce 34 100 LT reduce 48 21 RBRACE reduce 15 22 COMMA reduce 35 129 PRINTLN shift 58 22 SEMI reduce 35 100 NE reduce 48 3 NE reduce 47 74 NE reduce 46 40 AMP shift 53 14 ID shift 22 44 ID shift 22 17 ID shift 22 25 ID shift 22 13 ID shift 22 9 ID shift 22 94 RETURN reduce 11 46 NULL shift 8 52 NULL shift 8 66 NULL shift 8 19 AMP shift 53 71 AMP shift 53 118 ID shift 22 2 ID shift 22 54 ID shift 69 80 NULL shift 8 129 RETURN shift 70 61 PLUS reduce 30 60 PLUS reduce 29 11 PLUS reduce 28 59 DELETE reduce 15 22 PCT reduce 35 31 MINUS shift 71 32 MINUS shift 71 33 MINUS shift 71 34 MINUS shift 71 35 MINUS shift 71 36 MINUS shift 71 105 NUM shift 30 104 NUM shift 30 85 arglist shift 72 22 RBRACK reduce 35 6 DELETE reduce 13 7 DELETE reduce 12 109 RETURN shift 73 88 LPAREN shift 2 12 PLUS shift 19 53 ID shift 74 105 LPAREN shift 2 104 LPAREN shift 2 106 LPAREN shift 2 86 LPAREN shift 2 22 MINUS reduce 35 90 BECOMES reduce 43 93 BECOMES reduce 42 97 BECOMES reduce 38 127 BECOMES reduce 39 102 BECOMES reduce 40 30 BECOMES reduce 36 8 BECOMES reduce 37 70 NUM shift 30 116 BECOMES reduce 41 19 NUM shift 30 71 NUM shift 30 73 expr shift 75 94 STAR reduce 11 126 LBRACE shift 76 125 LBRACE shift 77 100 SLASH reduce 48 3 SLASH reduce 47 96 LBRACE shift 78 74 SLASH reduce 46 55 LBRACK shift 79 40 STAR shift 5 128 INT reduce 11 2 NEW shift 15 22 LPAREN shift 80 127 NE reduce 39 102 NE reduce 40 93 NE reduce 42 97 NE reduce 38 90 NE reduce 43 116 NE reduce 41 116 MINUS reduce 41 38 STAR shift 40 78 RETURN reduce 15 112 INT shift 4 30 NE reduce 36 8 NE reduce 37 30 MINUS reduce 36 8 MINUS reduce 37 118 NEW shift 15 127 MINUS reduce 39 102 MINUS reduce 40 93 MINUS reduce 42 97 MINUS reduce 38 90 MINUS reduce 43 77 RETURN reduce 15 76 RETURN reduce 15 39 EOF reduce 1 6 WHILE reduce 13 7 WHILE reduce 12 28 EOF reduce 2 59 PRINTLN reduce 15 113 RBRACE shift 81 114 RBRACE shift 82 127 RBRACK reduce 39 102 RBRACK reduce 40 93 RBRACK reduce 42 97 RBRACK reduce 38 109 lvalue shift 67 90 RBRACK reduce 43 116 RBRACK reduce 41 115 RBRACE shift 83 30 RBRACK reduce 36 8 RBRACK reduce 37 21 PRINTLN reduce 15 14 LPAREN shift 2 44 LPAREN shift 2 17 LPAREN shift 2 25 LPAREN shift 2 13 LPAREN shift 2 9 LPAREN shift 2 112 params shift 84 12 COMMA shift 85 75 MINUS shift 71 22 SLASH reduce 35 103 RPAREN reduce 8 5 NUM shift 30 67 BECOMES shift 86 11 RBRACK reduce 28 61 COMMA reduce 30 60 COMMA reduce 29 61 RBRACK reduce 30 60 RBRACK reduce 29 11 COMMA reduce 28 74 PCT reduce 46 3 PCT reduce 47 100 PCT reduce 48 75 PLUS shift 19 5 LPAREN shift 2 112 type shift 42 85 ID shift 22 3 BECOMES reduce 47 74 BECOMES reduce 46 100 BECOMES reduce 48 85 term shift 11 116 SEMI reduce 41 64 MINUS shift 71 93 SEMI reduce 42 97 SEMI reduce 38 65 MINUS shift 71 90 SEMI reduce 43 80 LPAREN shift 2 75 SEMI shift 87 130 RBRACE reduce 17 68 RBRACE reduce 20 131 RBRACE reduce 21 14 AMP shift 53 44 AMP shift 53 17 AMP shift 53 25 AMP shift 53 13 AMP shift 53 9 AMP shift 53 82 RBRACE reduce 19 79 RBRACK shift 88 127 SEMI reduce 39 102 SEMI reduce 40 30 SEMI reduce 36 8 SEMI reduce 37 83 RBRACE reduce 18 68 PRINTLN reduce 20 131 PRINTLN reduce 21 130 PRINTLN reduce 17 47 PLUS reduce 32 48 PLUS reduce 33 49 PLUS reduce 34 82 PRINTLN reduce 19 10 PLUS reduce 31 109 WHILE shift 43 83 PRINTLN reduce 18 65 PLUS shift 19 64 PLUS shift 19 77 STAR reduce 15 76 STAR reduce 15 10 SEMI reduce 31 78 STAR reduce 15 73 NULL shift 8 46 LPAREN shift 2 52 LPAREN shift 2 66 LPAREN shift 2 4 STAR shift 89 47 SEMI reduce 32 48 SEMI reduce 33 49 SEMI reduce 34 116 RPAREN reduce 41 40 NUM shift 30 30 RPAREN reduce 36 8 RPAREN reduce 37 127 RPAREN reduce 39 102 RPAREN reduce 40 50 RPAREN shift 90 93 RPAREN reduce 42 97 RPAREN reduce 38 105 NULL shift 8 104 NULL shift 8 90 RPAREN reduce 43 109 DELETE shift 55 18 procedure shift 18 100 PLUS reduce 48 74 PLUS reduce 46 3 PLUS reduce 47 85 factor shift 10 10 NE reduce 31 47 NE reduce 32 48 NE reduce 33 49 NE reduce 34 94 DELETE reduce 11 116 EQ reduce 41 100 COMMA reduce 48 30 GT reduce 36 8 GT reduce 37 3 COMMA reduce 47 93 GT reduce 42 97 GT reduce 38 127 GT reduce 39 102 GT reduce 40 1 RPAREN reduce 6 74 COMMA reduce 46 27 RBRACE shift 91 90 GE reduce 43 93 GE reduce 42 97 GE reduce 38 116 GE reduce 41 83 WHILE reduce 18 30 GE reduce 36 8 GE reduce 37 127 GE reduce 39 102 GE reduce 40 21 LPAREN reduce 15 6 STAR reduce 13 7 STAR reduce 12 82 WHILE reduce 19 68 WHILE reduce 20 131 WHILE reduce 21 130 WHILE reduce 17 61 PCT shift 66 60 PCT shift 66 80 NUM shift 30 20 dcl shift 29 99 RPAREN shift 92 128 ID reduce 11 57 LPAREN reduce 16 80 RPAREN shift 93 92 LBRACE shift 94 14 NUM shift 30 44 NUM shift 30 17 NUM shift 30 25 NUM shift 30 13 NUM shift 30 9 NUM shift 30 90 GT reduce 43 116 GT reduce 41 45 NULL shift 95 128 IF reduce 11 81 ELSE shift 96 57 DELETE reduce 16 64 RPAREN shift 97 73 AMP shift 53 62 EOF shift 98 21 STAR reduce 15 118 factor shift 10 105 factor shift 10 104 factor shift 10 2 factor shift 10 29 RPAREN reduce 7 100 RPAREN reduce 48 105 ID shift 22 104 ID shift 22 82 LPAREN reduce 19 20 INT shift 4 88 factor shift 10 130 LPAREN reduce 17 106 factor shift 10 86 factor shift 10 68 LPAREN reduce 20 131 LPAREN reduce 21 26 dcl shift 99 19 ID shift 22 71 ID shift 22 74 RPAREN reduce 46 111 RPAREN shift 100 3 RPAREN reduce 47 83 LPAREN reduce 18 24 dcl shift 101 5 factor shift 102 20 paramlist shift 103 107 LPAREN shift 104 43 LPAREN shift 105 58 LPAREN shift 106 12 MINUS shift 71 11 MINUS reduce 28 61 MINUS reduce 30 60 MINUS reduce 29 59 INT shift 4 93 LT reduce 42 97 LT reduce 38 90 LT reduce 43 30 LT reduce 36 8 LT reduce 37 127 LT reduce 39 102 LT reduce 40 91 INT reduce 3 116 LT reduce 41 93 LE reduce 42 97 LE reduce 38 108 PLUS shift 19 127 LE reduce 39 102 LE reduce 40 30 LE reduce 36 8 LE reduce 37 129 ID shift 74 116 LE reduce 41 129 IF shift 107 90 LE reduce 43 46 ID shift 22 52 ID shift 22 66 ID shift 22 70 NEW shift 15 88 NULL shift 8 106 NULL shift 8 86 NULL shift 8 10 EQ reduce 31 47 EQ reduce 32 48 EQ reduce 33 49 EQ reduce 34 80 STAR shift 5 6 PRINTLN reduce 13 7 PRINTLN reduce 12 22 LT reduce 35 59 LPAREN reduce 15 59 type shift 42 73 NEW shift 15 22 LE reduce 35 109 STAR shift 40 105 expr shift 108 104 expr shift 108 93 PLUS reduce 42 97 PLUS reduce 38 90 PLUS reduce 43 116 PLUS reduce 41 30 PLUS reduce 36 8 PLUS reduce 37 127 PLUS reduce 39 102 PLUS reduce 40 10 GT reduce 31 47 GT reduce 32 48 GT reduce 33 49 GT reduce 34 109 IF shift 107 109 ID shift 74 80 AMP shift 53 108 MINUS shift 71 10 GE reduce 31 47 GE reduce 32 48 GE reduce 33 49 GE reduce 34 21 statements shift 109 109 LPAREN shift 38 59 dcl shift 63 128 DELETE reduce 11 40 ID shift 22 84 RPAREN shift 110 88 NUM shift 30 106 NUM shift 30 86 NUM shift 30 40 LPAREN shift 2 38 lvalue shift 111 22 BECOMES reduce 35 40 NEW shift 15 69 LPAREN shift 112 77 statements shift 113 76 statements shift 114 73 term shift 11 78 statements shift 115 53 STAR shift 40 57 STAR reduce 16 93 EQ reduce 42 97 EQ reduce 38 90 EQ reduce 43 30 EQ reduce 36 8 EQ reduce 37 127 EQ reduce 39 102 EQ reduce 40 85 AMP shift 53 47 LT reduce 32 48 LT reduce 33 49 LT reduce 34 10 LT reduce 31 117 COMMA reduce 14 18 INT shift 54 83 RETURN reduce 18 10 LE reduce 31 3 MINUS reduce 47 129 statement shift 57 74 MINUS reduce 46 22 NE reduce 35 10 RPAREN reduce 31 100 MINUS reduce 48 47 LE reduce 32 48 LE reduce 33 49 LE reduce 34 106 term shift 11 86 term shift 11 130 RETURN reduce 17 47 RPAREN reduce 32 48 RPAREN reduce 33 49 RPAREN reduce 34 70 AMP shift 53 88 term shift 11 68 RETURN reduce 20 131 RETURN reduce 21 82 RETURN reduce 19 105 term shift 11 104 term shift 11 82 STAR reduce 19 22 STAR reduce 35 83 STAR reduce 18 77 LPAREN reduce 15 76 LPAREN reduce 15 65 RBRACK shift 116 70 STAR shift 5 68 STAR reduce 20 131 STAR reduce 21 78 LPAREN reduce 15 130 STAR reduce 17 129 DELETE shift 55 121 MINUS shift 71 78 DELETE reduce 15 42 ID shift 117 77 DELETE reduce 15 76 DELETE reduce 15 113 ID shift 74 114 ID shift 74 113 IF shift 107 114 IF shift 107 115 ID shift 74 115 IF shift 107 38 ID shift 74 123 PLUS shift 19 124 PLUS shift 19 122 PLUS shift 19 47 SLASH reduce 32 48 SLASH reduce 33 49 SLASH reduce 34 10 SLASH reduce 31 41 LBRACK shift 118 14 NEW shift 15 44 NEW shift 15 17 NEW shift 15 25 NEW shift 15 13 NEW shift 15 9 NEW shift 15 105 STAR shift 5 104 STAR shift 5 105 test shift 119 104 test shift 120 5 AMP shift 53 122 MINUS shift 71 123 MINUS shift 71 124 MINUS shift 71 70 expr shift 121 100 SEMI reduce 48 73 ID shift 22 3 SEMI reduce 47 74 SEMI reduce 46 113 WHILE shift 43 114 WHILE shift 43 88 ID shift 22 106 ID shift 22 86 ID shift 22 22 GE reduce 35 115 WHILE shift 43 88 expr shift 122 106 expr shift 123 86 expr shift 124 120 RPAREN shift 125 119 RPAREN shift 126 22 GT reduce 35 129 lvalue shift 67 11 SEMI reduce 28 6 IF reduce 13 7 IF reduce 12 61 SEMI reduce 30 60 SEMI reduce 29 53 lvalue shift 127 6 ID reduce 13 7 ID reduce 12 88 AMP shift 53 89 ID reduce 10 110 LBRACE shift 128 106 AMP shift 53 86 AMP shift 53 83 IF reduce 18 83 ID reduce 18 82 IF reduce 19 130 IF reduce 17 82 ID reduce 19 68 IF reduce 20 131 IF reduce 21 31 RPAREN reduce 22 32 RPAREN reduce 23 33 RPAREN reduce 24 34 RPAREN reduce 25 35 RPAREN reduce 26 36 RPAREN reduce 27 21 type shift 42 6 RETURN reduce 13 7 RETURN reduce 12 59 statements shift 129 68 ID reduce 20 131 ID reduce 21 130 ID reduce 17 22 EQ reduce 35 11 EQ reduce 28 73 factor shift 10 61 EQ reduce 30 60 EQ reduce 29 85 NULL shift 8 115 PRINTLN shift 58 124 SEMI shift 130 122 SEMI shift 131 21 RETURN reduce 15 113 PRINTLN shift 58 114 PRINTLN shift 58 21 DELETE reduce 15 ";
+// The tables the parser actually runs on, a compressed form of the
+// automaton in wlp4tables.h small enough to stay in L1 as the grammar
+// grows:
+// - a state that reduces reduces by its most common rule on every
+//   lookahead it has no other action for. Delaying an error this way
+//   only ever adds reductions before it is found, never a shift, so
+//   it is still reported at the same token;
+// - the remaining terminal actions, and the gotos, are each packed
+//   into a comb vector by row displacement.
 
+// The automaton split into default reductions, the other terminal
+// actions, and the gotos (transposed, one row per nonterminal, holding
+// the target state + 1); 0 marks an absent entry
+struct SparseTables {
+	int16_t defaults[WLP4::NUM_STATES];
+	int16_t actions[WLP4::NUM_STATES][WLP4::NUM_TERMINALS];
+	int16_t gotos[WLP4::NUM_NONTERMINALS][WLP4::NUM_STATES];
+	constexpr SparseTables(const int16_t (&action)[WLP4::NUM_STATES][WLP4::NUM_SYMBOLS]) : defaults{}, actions{}, gotos{} {
+		for (int state = 0; state < WLP4::NUM_STATES; ++state) {
+			const int16_t *row = action[state];
+			int best = 0;
+			for (int t = 0; t < WLP4::NUM_TERMINALS; ++t) {
+				if (row[t] >= 0) continue;
+				int count = 0;
+				for (int u = 0; u < WLP4::NUM_TERMINALS; ++u) count += row[u] == row[t];
+				if (count > best) {
+					best = count;
+					defaults[state] = row[t];
+				}
+			}
+			for (int t = 0; t < WLP4::NUM_TERMINALS; ++t) {
+				if (row[t] != defaults[state]) actions[state][t] = row[t];
+			}
+			for (int n = 0; n < WLP4::NUM_NONTERMINALS; ++n) {
+				gotos[n][state] = row[WLP4::NUM_TERMINALS + n];
+			}
+		}
+	}
+};
+
+// Where row displacement places the rows of a sparse table: row r's
+// entry for column c goes to slot base[r] + c. Rows are placed densest
+// first, each at the lowest base where it collides with nothing placed
+// so far. size is the number of slots needed to look up any column of
+// any row.
+template <int Rows, int Cols>
+struct CombLayout {
+	int base[Rows];
+	int size;
+	constexpr CombLayout(const int16_t (&table)[Rows][Cols]) : base{}, size{ 0 } {
+		bool used[Rows * Cols + Cols] = {};
+		bool placed[Rows] = {};
+		for (int k = 0; k < Rows; ++k) {
+			int r = 0, most = -1;
+			for (int i = 0; i < Rows; ++i) {
+				int count = 0;
+				for (int c = 0; c < Cols; ++c) count += table[i][c] != 0;
+				if (!placed[i] && count > most) {
+					most = count;
+					r = i;
+				}
+			}
+			int b = 0;
+			for (bool fits = false; !fits; ) {
+				fits = true;
+				for (int c = 0; c < Cols && fits; ++c) fits = !(table[r][c] && used[b + c]);
+				if (!fits) ++b;
+			}
+			for (int c = 0; c < Cols; ++c) {
+				if (table[r][c]) used[b + c] = true;
+			}
+			placed[r] = true;
+			base[r] = b;
+			if (b + Cols > size) size = b + Cols;
+		}
+	}
+};
+
+// A sparse table packed into a comb vector; check says which row owns
+// each slot
+template <int Rows, int Cols, int Size>
+struct Comb {
+	int16_t base[Rows];
+	uint16_t check[Size];
+	int16_t value[Size];
+	constexpr Comb(const int16_t (&table)[Rows][Cols], const CombLayout<Rows, Cols> &layout) : base{}, check{}, value{} {
+		for (int i = 0; i < Size; ++i) check[i] = Rows;
+		for (int r = 0; r < Rows; ++r) {
+			base[r] = layout.base[r];
+			for (int c = 0; c < Cols; ++c) {
+				if (table[r][c]) {
+					check[base[r] + c] = r;
+					value[base[r] + c] = table[r][c];
+				}
+			}
+		}
+	}
+	// The entry at row r, column c, or 0
+	int16_t lookup(int r, int c) const {
+		int i = base[r] + c;
+		return check[i] == r ? value[i] : 0;
+	}
+};
+
+constexpr SparseTables sparseTables(WLP4::action);
+constexpr CombLayout<WLP4::NUM_STATES, WLP4::NUM_TERMINALS> actionLayout(sparseTables.actions);
+constexpr CombLayout<WLP4::NUM_NONTERMINALS, WLP4::NUM_STATES> gotoLayout(sparseTables.gotos);
+
+struct ParseTables {
+	int16_t defaults[WLP4::NUM_STATES];
+	Comb<WLP4::NUM_STATES, WLP4::NUM_TERMINALS, actionLayout.size> actions;
+	Comb<WLP4::NUM_NONTERMINALS, WLP4::NUM_STATES, gotoLayout.size> gotos;
+	constexpr ParseTables(const SparseTables &sparse) : defaults{},
+		actions(sparse.actions, actionLayout), gotos(sparse.gotos, gotoLayout) {
+		for (int state = 0; state < WLP4::NUM_STATES; ++state) defaults[state] = sparse.defaults[state];
+	}
+
+	// The action in state on symbol, encoded as in WLP4::action. A
+	// nonterminal, which only a text token stream can present as input,
+	// is shifted exactly when it has a goto.
+	int16_t action(int state, int symbol) const {
+		if (symbol >= WLP4::NUM_TERMINALS) return go(state, symbol);
+		int16_t act = actions.lookup(state, symbol);
+		return act ? act : defaults[state];
+	}
+	// The goto of state on nonterminal, encoded as a shift
+	int16_t go(int state, int nonTerminal) const {
+		return gotos.lookup(nonTerminal - WLP4::NUM_TERMINALS, state);
+	}
+};
+
+constexpr ParseTables parseTables(sparseTables);
+
+// The uncompressed automaton behind the same interface, to measure
+// ParseTables against
+struct DenseTables {
+	int16_t action(int state, int symbol) const {
+		return WLP4::action[state][symbol];
+	}
+	int16_t go(int state, int nonTerminal) const {
+		return WLP4::action[state][nonTerminal];
+	}
+};
+
+// A node of the parse tree. Nodes, their lexemes and their child lists
+// all live in an Arena of the parser and are freed together with it.
 struct Node {
-	string type;
-	string lexeme;
+	// The grammar symbol id of the node, or -1 for an input token that
+	// names no symbol
+	int symbol;
 	int numOfChild;
-	vector<Node *> children;
-	Node(string type, string lexeme) :type{ type }, lexeme{ lexeme }, numOfChild{ 0 } {}
-	void addChild(Node *node) {
-		children.push_back(node);
-		numOfChild++;
+	// The children, a contiguous range in the arena
+	Node **children;
+	const char *lexeme;
+	size_t lexemeLength;
+	// The rule a reduction built this node with, or -1 for a token
+	int rule;
+
+	const char *type() const {
+		return WLP4::symbolNames[symbol];
 	}
 
-	void printNode() {
+	// Appends the line of this node's rule, or of the token for a leaf
+	void printLine(string &out) const {
+		out += type();
 		if (numOfChild == 0) {
-			cout << type;
-			if(lexeme != ""){
-			 cout<< " " << lexeme;
+			if (lexemeLength != 0) {
+				out += ' ';
+				out.append(lexeme, lexemeLength);
 			}
-			cout<<endl;
-			return;
 		}
-		cout << type << " ";
 		for (int i = 0; i < numOfChild; i++) {
-			cout << children[i]->type;
-			if (i != numOfChild - 1) cout << " ";
-		}
-		cout << endl;
-		for (int i = 0; i < numOfChild; i++) {
-			children[i]->printNode();
+			out += ' ';
+			out += children[i]->type();
 		}
+		out += '\n';
 	}
-	~Node() {
+
+	// Appends the derivation of the subtree, one line per node in preorder
+	void printNode(string &out) const {
+		printLine(out);
 		for (int i = 0; i < numOfChild; i++) {
-			delete children[i];
+			children[i]->printNode(out);
 		}
-		delete this;
 	}
 };
 
 class Lr {
-	//Skip the grammar part of the input.
-	int numTerm = 35, numNonTerm = 17, numRules = 49, numTrans = 863, numStates = 132;
-	string startState = "start";
-	string initialRule = "start BOF procedures EOF", finalSymbolStack = "BOF procedures EOF";
-	vector<string> terminals = {
-		"AMP"
-		"BECOMES"
-		"BOF"
-		"COMMA"
-		"DELETE"
-		"ELSE"
-		"EOF"
-		"EQ"
-		"GE"
-		"GT"
-		"ID"
-		"IF"
-		"INT"
-		"LBRACE"
-		"LBRACK"
-		"LE"
-		"LPAREN"
-		"LT"
-		"MINUS"
-		"NE"
-		"NEW"
-		"NULL"
-		"NUM"
-		"PCT"
-		"PLUS"
-		"PRINTLN"
-		"RBRACE"
-		"RBRACK"
-		"RETURN"
-		"RPAREN"
-		"SEMI"
-		"SLASH"
-		"STAR"
-		"WAIN"
-		"WHILE"
-	};
-
-	vector<string> nonTerminals = {
-		"start"
-		"dcl"
-		"dcls"
-		"expr"
-		"factor"
-		"lvalue"
-		"procedure"
-		"procedures"
-		"main"
-		"params"
-		"paramlist"
-		"statement"
-		"statements"
-		"term"
-		"test"
-		"type"
-		"arglist"
-		"start"
-	};
-    //const char *ruleStringArray[] = {
-    vector<string> rules={
-		"start BOF procedures EOF",
-		"procedures procedure procedures",
-		"procedures main",
-		"procedure INT ID LPAREN params RPAREN LBRACE dcls statements RETURN expr SEMI RBRACE",
-		"main INT WAIN LPAREN dcl COMMA dcl RPAREN LBRACE dcls statements RETURN expr SEMI RBRACE",
-		"params",
-		"params paramlist",
-		"paramlist dcl",
-		"paramlist dcl COMMA paramlist",
-		"type INT",
-		"type INT STAR",
-		"dcls",
-		"dcls dcls dcl BECOMES NUM SEMI",
-		"dcls dcls dcl BECOMES NULL SEMI",
-		"dcl type ID",
-		"statements",
-		"statements statements statement",
-		"statement lvalue BECOMES expr SEMI",
-		"statement IF LPAREN test RPAREN LBRACE statements RBRACE ELSE LBRACE statements RBRACE",
-		"statement WHILE LPAREN test RPAREN LBRACE statements RBRACE",
-		"statement PRINTLN LPAREN expr RPAREN SEMI",
-		"statement DELETE LBRACK RBRACK expr SEMI",
-		"test expr EQ expr",
-		"test expr NE expr",
-		"test expr LT expr",
-		"test expr LE expr",
-		"test expr GE expr",
-		"test expr GT expr",
-		"expr term",
-		"expr expr PLUS term",
-		"expr expr MINUS term",
-		"term factor",
-		"term term STAR factor",
-		"term term SLASH factor",
-		"term term PCT factor",
-		"factor ID",
-		"factor NUM",
-		"factor NULL",
-		"factor LPAREN expr RPAREN",
-		"factor AMP lvalue",
-		"factor STAR factor",
-		"factor NEW INT LBRACK expr RBRACK",
-		"factor ID LPAREN RPAREN",
-		"factor ID LPAREN arglist RPAREN",
-		"arglist expr",
-		"arglist expr COMMA arglist",
-		"lvalue ID",
-		"lvalue STAR factor",
-		"lvalue LPAREN lvalue RPAREN"
-	};
-	//vector<string> rules(ruleStringArray, end(ruleStringArray));
-	vector<string> reduceRules;
+	static const int NUM_STATES = WLP4::NUM_STATES;
+	// The full table, for the listings below
+	const int16_t (&action)[NUM_STATES][WLP4::NUM_SYMBOLS] = WLP4::action;
+	const ParseTables &tables = parseTables;
+	Arena arena;
+	// Where makeNode allocates; -watch gives every reparse an Arena
+	Arena *current = &arena;
 	vector<Node *> symbolStack;
-	vector<Node *> inputSymbolStack;
-	vector<string> stateStack;
-	std::unordered_map<string, string> transfer;
+	vector<uint16_t> stateStack;
+
+	// A Node with no children (yet); lexeme must outlive the tree
+	Node *makeNode(int symbol, const char *lexeme, size_t lexemeLength) {
+		Node *node = current->allocateArray<Node>(1);
+		*node = Node{ symbol, 0, nullptr, lexeme, lexemeLength, -1 };
+		return node;
+	}
 
 	void skipLine(istream &in) {
 		string s;
 		getline(in, s);
 	}
 
-	void storeTransfer() {
-		istringstream in(machine);
-		string startState;
-		string transSymbol;
-		string operation;
-		string OpNum;
-		for (int i = 0; i < numTrans; i++) {
-			in >> startState;
-			in >> transSymbol;
-			in >> operation;
-			in >> OpNum;
-			transfer[startState + " " + transSymbol] = operation + " " + OpNum;
+	// The id of the grammar symbol with the given name, or -1. The
+	// terminals are in alphabetical order.
+	static int symbolId(const string &name) {
+		const char *const *begin = WLP4::symbolNames;
+		const char *const *end = begin + WLP4::NUM_TERMINALS;
+		const char *const *it = lower_bound(begin, end, name, [](const char *a, const string &b) { return b.compare(a) > 0; });
+		if (it != end && name == *it) return it - begin;
+		for (int i = WLP4::NUM_TERMINALS; i < WLP4::NUM_SYMBOLS; i++) {
+			if (name == WLP4::symbolNames[i]) return i;
 		}
+		return -1;
 	}
 
-	string trim(const string &str) {
+	static string trim(const string &str) {
 		size_t begin = str.find_first_not_of(" \t\n");
 		if (begin == string::npos) return "";
 
@@ -201,6 +254,108 @@ class Lr {
 		return str.substr(begin, end - begin + 1);
 	}
 
+	// The text of rule r, as in the grammar
+	static string ruleString(int r) {
+		const WLP4::Rule &rule = WLP4::rules[r];
+		string s = WLP4::symbolNames[rule.lhs];
+		for (int i = 0; i < rule.length; i++) {
+			s += " ";
+			s += WLP4::symbolNames[rule.rhs[i]];
+		}
+		return s;
+	}
+
+	// Reads the input tokens, in either format, one at a time as the
+	// parser asks for them: BOF, the tokens of the input, then EOF.
+	// Nothing is read past the current token but the rest of a block
+	// of the binary format.
+	class TokenReader {
+		istream &in;
+		bool binary = false;
+		// Before BOF, between BOF and EOF, or past EOF
+		enum { START, TOKENS, END } stage = START;
+		string line, type, word;
+		// The binary input read so far, decoded up to pos
+		string data;
+		size_t pos = 0;
+
+		// Makes sure n bytes after pos are read, unless the input ends
+		// first
+		bool fill(size_t n) {
+			if (data.size() - pos >= n) return true;
+			data.erase(0, pos);
+			pos = 0;
+			char chunk[65536];
+			while (data.size() < n && (in.read(chunk, sizeof chunk) || in.gcount() > 0)) {
+				data.append(chunk, in.gcount());
+			}
+			return data.size() >= n;
+		}
+		static void malformed() {
+			throw string("ERROR: malformed token stream");
+		}
+		bool set(int s, const char *l, size_t n) {
+			symbol = s;
+			lexeme = l;
+			length = n;
+			return true;
+		}
+		bool nextText() {
+			if (!getline(in, line)) return false;
+			istringstream iss(trim(line));
+			type.clear();
+			word.clear();
+			iss >> type;
+			iss >> word;
+			return set(symbolId(type), word.data(), word.size());
+		}
+		// The binary format of wlp4binary.h
+		bool nextBinary() {
+			if (!fill(1)) return false;
+			unsigned terminal = static_cast<unsigned char>(data[pos]);
+			if (terminal >= WLP4::NUM_TERMINALS) malformed();
+			if (!WLP4::hasLexeme(terminal)) {
+				++pos;
+				const char *spelling = WLP4::terminalSpellings[terminal];
+				return set(terminal, spelling, strlen(spelling));
+			}
+			fill(6);
+			uint32_t n;
+			const char *p = WLP4::decodeVarint(data.data() + pos + 1, data.data() + data.size(), n);
+			if (!p) malformed();
+			size_t header = p - (data.data() + pos);
+			if (!fill(header + n)) malformed();
+			set(terminal, data.data() + pos + header, n);
+			pos += header + n;
+			return true;
+		}
+
+	public:
+		// The current token; lexeme is valid until the next call to next
+		int symbol = -1;
+		const char *lexeme = nullptr;
+		size_t length = 0;
+
+		explicit TokenReader(istream &in) : in(in) {}
+		// Moves to the next token, returning false after EOF
+		bool next() {
+			if (stage == START) {
+				stage = TOKENS;
+				// wlp4scan -b output is told apart from text by its first byte
+				binary = in.peek() == static_cast<unsigned char>(WLP4::tokenMagic[0]);
+				if (binary) {
+					if (!fill(sizeof WLP4::tokenMagic) || !equal(WLP4::tokenMagic, WLP4::tokenMagic + sizeof WLP4::tokenMagic, data.data())) malformed();
+					pos = sizeof WLP4::tokenMagic;
+				}
+				return set(WLP4::BOF, "BOF", 3);
+			}
+			if (stage == END) return false;
+			if (binary ? nextBinary() : nextText()) return true;
+			stage = END;
+			return set(WLP4::EOF_, "EOF", 3);
+		}
+	};
+
 	// Prints the derivation with whitespace trimmed.
 	void printDerivation(istream &in, ostream &out) {
 		string line;
@@ -211,101 +366,715 @@ class Lr {
 	}
 
 public:
-	Lr() { storeTransfer(); }
+	Lr() {}
 	void printOutTransfers() {
-		for (auto it = transfer.begin(); it != transfer.end(); ++it)
-			std::cout << it->first << " " << it->second << endl;
+		for (int state = 0; state < NUM_STATES; ++state) {
+			for (int symbol = 0; symbol < WLP4::NUM_SYMBOLS; ++symbol) {
+				int16_t act = action[state][symbol];
+				if (act > 0) std::cout << state << " " << WLP4::symbolNames[symbol] << " shift " << act - 1 << endl;
+				else if (act < 0) std::cout << state << " " << WLP4::symbolNames[symbol] << " reduce " << -act - 1 << endl;
+			}
+		}
 	}
 
-	void parse(istream &in) {
-		string s;
-		// we create note for each input tokens
-		inputSymbolStack.push_back(new Node{ "BOF","BOF" });
-		while (getline(in, s)) {
-			s = trim(s);
-			istringstream iss(s);
-			string type;
-			string lexeme;
-			iss >> type;
-			iss >> lexeme;
-			Node * n = new Node{ type, lexeme };
-			inputSymbolStack.push_back(n);
-		}
-		inputSymbolStack.push_back(new Node{ "EOF","EOF" });
-		int totalNumSymbol = inputSymbolStack.size();
-		std::reverse(inputSymbolStack.begin(), inputSymbolStack.end());
-		stateStack.push_back("0");
-		// for(int i = 0; i < inputSymbolStack.size(); i++){
-		// 	inputSymbolStack[i]->printNode();
-		// }
-		while (1) {
-			if (inputSymbolStack.size() == 0) break;
-			Node *inputSymbol = inputSymbolStack.back();
-			inputSymbolStack.pop_back();
-			auto it = transfer.find(stateStack.back() + " " + inputSymbol->type);
-			if (it == transfer.end()) {
-				int num1 = totalNumSymbol - inputSymbolStack.size() - 1;
-				stringstream ss;
-				ss << num1;
-				string str = ss.str();
-				string a = "ERROR at " + str;
-				throw string(a);
-			}
-			string action = it->second;
-			string actionType = action.substr(0, action.find(" "));
-			string num = action.substr(action.find(" ") + 1, action.length() - action.find(" ") - 1);
-			//cout<<action<<endl;
-			if (actionType == "reduce") {
-				
-				inputSymbolStack.push_back(inputSymbol);
-
-				istringstream buffer(num);
-				int num;
-				buffer >> num;
-				string reduceRule = rules[num];
-
-				//cout<<reduceRule<<endl;
-				// printVec(symbolStack);
-				// printVec(inputSymbolStack);
-				// printVec(stateStack);
-				int n = std::count(reduceRule.begin(), reduceRule.end(), ' ');
-				Node * newNode = new Node{ reduceRule.substr(0, reduceRule.find(" ")), "" };
-				//cout<<reduceRule.substr(0, reduceRule.find(" "))<<endl;
-				for (int i = symbolStack.size() - n; i<symbolStack.size(); i++) {
-					newNode->addChild(symbolStack.at(i));
+private:
+	// Writes the derivation of the tree under the start rule whose
+	// children are roots in the binary format of wlp4binary.h
+	static void writeDerivation(Node *const *roots, int numRoots) {
+		string out(WLP4::derivationMagic, sizeof WLP4::derivationMagic);
+		out += static_cast<char>(0);
+		vector<const Node *> pending(roots, roots + numRoots);
+		reverse(pending.begin(), pending.end());
+		while (!pending.empty()) {
+			const Node *node = pending.back();
+			pending.pop_back();
+			if (node->rule >= 0) {
+				out += static_cast<char>(node->rule);
+				for (int i = node->numOfChild - 1; i >= 0; i--) {
+					pending.push_back(node->children[i]);
+				}
+			}
+			else {
+				out += static_cast<char>(WLP4::LEAF | node->symbol);
+				if (!WLP4::fixedSpelling(node->symbol)) {
+					char length[5];
+					out.append(length, WLP4::encodeVarint(node->lexemeLength, length));
+					out.append(node->lexeme, node->lexemeLength);
+				}
+			}
+			// Hand over big derivations in pieces
+			if (out.size() >= 1 << 16) {
+				cout.write(out.data(), out.size());
+				out.clear();
+			}
+		}
+		cout.write(out.data(), out.size());
+	}
+
+	// The input of drive: peek() is the next input, or null at the end,
+	// and token() the index of its first token, BOF being token 0.
+
+	// The tokens of a stream, made into Nodes as the parser gets to them
+	class StreamInput {
+		Lr &lr;
+		TokenReader reader;
+		Node *lookahead = nullptr;
+		size_t index = 0;
+		bool ended = false;
+	public:
+		StreamInput(Lr &lr, istream &in) : lr(lr), reader(in) {}
+		Node *peek() {
+			if (!lookahead && !ended) {
+				if (reader.next()) lookahead = lr.makeNode(reader.symbol, lr.current->copy(reader.lexeme, reader.length), reader.length);
+				else ended = true;
+			}
+			return lookahead;
+		}
+		size_t token() const {
+			return index;
+		}
+		void advance() {
+			lookahead = nullptr;
+			++index;
+		}
+		// A stream has only tokens
+		void expand() {}
+	};
+
+	// The input of -watch: tokens, and subtrees kept from an earlier
+	// parse, each with the index of its first token
+	class KeptInput {
+		Lr &lr;
+		vector<Node *> nodes;
+		vector<uint32_t> firstToken;
+		size_t next = 0;
+	public:
+		explicit KeptInput(Lr &lr) : lr(lr) {}
+		void push(Node *node, uint32_t first) {
+			nodes.push_back(node);
+			firstToken.push_back(first);
+		}
+		Node *peek() const {
+			return next < nodes.size() ? nodes[next] : nullptr;
+		}
+		size_t token() const {
+			return firstToken[next];
+		}
+		void advance() {
+			++next;
+		}
+		// Replaces the next input, a kept subtree, with copies of its
+		// tokens
+		void expand() {
+			vector<Node *> leaves;
+			vector<const Node *> pending(1, nodes[next]);
+			while (!pending.empty()) {
+				const Node *node = pending.back();
+				pending.pop_back();
+				if (node->rule < 0) {
+					leaves.push_back(lr.makeNode(node->symbol, lr.current->copy(node->lexeme, node->lexemeLength), node->lexemeLength));
 				}
-				// we process the symbol stack
-				symbolStack.erase(symbolStack.end() - n, symbolStack.end());
-				// printVec(symbolStack);
-				inputSymbolStack.push_back(newNode);
-				// printVec(inputSymbolStack);
+				for (int i = node->numOfChild - 1; i >= 0; i--) {
+					pending.push_back(node->children[i]);
+				}
+			}
+			vector<uint32_t> indexes(leaves.size());
+			for (size_t i = 0; i < leaves.size(); i++) {
+				indexes[i] = firstToken[next] + i;
+			}
+			nodes.erase(nodes.begin() + next);
+			nodes.insert(nodes.begin() + next, leaves.begin(), leaves.end());
+			firstToken.erase(firstToken.begin() + next);
+			firstToken.insert(firstToken.begin() + next, indexes.begin(), indexes.end());
+		}
+	};
 
-				// then we process the state stack
-				stateStack.erase(stateStack.end() - n, stateStack.end());
-				// printVec(stateStack);
+	// Reduces by rule r: builds its node and takes the goto on its lhs.
+	// Returns false if there is no goto.
+	bool reduce(int r) {
+		const WLP4::Rule &rule = WLP4::rules[r];
+		int n = rule.length;
+		Node * newNode = makeNode(rule.lhs, nullptr, 0);
+		newNode->rule = r;
+		newNode->numOfChild = n;
+		newNode->children = current->allocateArray<Node *>(n);
+		copy(symbolStack.end() - n, symbolStack.end(), newNode->children);
+		// we process the symbol stack
+		symbolStack.erase(symbolStack.end() - n, symbolStack.end());
+		// then we process the state stack
+		stateStack.erase(stateStack.end() - n, stateStack.end());
+		int16_t go = tables.go(stateStack.back(), rule.lhs);
+		if (go <= 0) return false;
+		symbolStack.push_back(newNode);
+		stateStack.push_back(go - 1);
+		return true;
+	}
 
+	// Runs the automaton over input, which starts with BOF and ends with
+	// EOF, asking for each input only once it is needed as lookahead. A
+	// node of input that has a rule is a procedure or main kept from an
+	// earlier parse. The reductions before it take its first token, INT,
+	// as the lookahead; it is then shifted whole if the state has a goto
+	// on it, and otherwise taken apart into its tokens.
+	template <typename Input>
+	void drive(Input &input) {
+		symbolStack.clear();
+		stateStack.assign(1, 0);
+		while (Node *inputSymbol = input.peek()) {
+			bool kept = inputSymbol->rule >= 0;
+			int lookahead = kept ? inputSymbol->children[0]->symbol : inputSymbol->symbol;
+			int16_t act = lookahead < 0 ? 0 : tables.action(stateStack.back(), lookahead);
+			if (act == 0) {
+				throw string("ERROR at " + to_string(input.token()));
 			}
-			else if (actionType == "shift") {
+			if (act < 0) {
+				if (!reduce(-act - 1)) {
+					throw string("ERROR at " + to_string(input.token() - 1));
+				}
+			}
+			else if (kept) {
+				int16_t go = tables.go(stateStack.back(), inputSymbol->symbol);
+				if (go <= 0) {
+					input.expand();
+					continue;
+				}
 				symbolStack.push_back(inputSymbol);
-				stateStack.push_back(num);
+				stateStack.push_back(go - 1);
+				input.advance();
+			}
+			else {
+				symbolStack.push_back(inputSymbol);
+				stateStack.push_back(act - 1);
+				input.advance();
+			}
+		}
+	}
+
+	bool accepted() const {
+		return symbolStack.size() == 3 && symbolStack[0]->symbol == WLP4::BOF &&
+			symbolStack[1]->symbol == WLP4::procedures && symbolStack[2]->symbol == WLP4::EOF_;
+	}
+
+	// The number of tokens under node
+	static uint32_t countTokens(const Node *node) {
+		uint32_t count = 0;
+		vector<const Node *> pending(1, node);
+		while (!pending.empty()) {
+			const Node *top = pending.back();
+			pending.pop_back();
+			if (top->rule < 0) count++;
+			pending.insert(pending.end(), top->children, top->children + top->numOfChild);
+		}
+		return count;
+	}
+
+	// A procedure or main of the last tree -watch printed: the tokens it
+	// spans in the current document (counted from the one after BOF), the
+	// bytes of its nodes in unitArena, and its lines of the derivation
+	// headed by the line of its link in the procedures spine. A unit stops
+	// being intact once an edit touches its tokens.
+	struct Unit {
+		Node *node;
+		uint32_t first;
+		uint32_t count;
+		bool intact;
+		size_t bytes;
+		shared_ptr<const string> text;
+	};
+	// The current document, as "type lexeme" per token, and the
+	// procedures and main of the last tree printed, in order. Their nodes
+	// are copied out of the Arena they were parsed in, which then goes
+	// with the rest of that parse, into unitArena; once more than half of
+	// what unitArena holds is dead it is compacted.
+	vector<string> lastTokens;
+	vector<Unit> units;
+	unique_ptr<Arena> unitArena{ new Arena };
+	size_t unitArenaBytes = 0;
+
+	// A copy of the subtree under node allocated in to, adding its size
+	// to bytes
+	static Node *copyTree(const Node *node, Arena &to, size_t &bytes) {
+		Node *copy = to.allocateArray<Node>(1);
+		*copy = *node;
+		if (node->lexemeLength != 0) copy->lexeme = to.copy(node->lexeme, node->lexemeLength);
+		copy->children = to.allocateArray<Node *>(node->numOfChild);
+		for (int i = 0; i < node->numOfChild; i++) {
+			copy->children[i] = copyTree(node->children[i], to, bytes);
+		}
+		bytes += sizeof(Node) + node->numOfChild * sizeof(Node *) + node->lexemeLength;
+		return copy;
+	}
+
+	// What an accepted edit did to the units: removed of them from first
+	// on were replaced by the new units [first, first + added)
+	struct Change {
+		size_t first;
+		size_t removed;
+		size_t added;
+	};
+
+	// Replaces count tokens of the document from start on with tokens,
+	// then parses it keeping every unit the edits since the last tree left
+	// intact. Only the tokens of the other units go through the automaton
+	// token by token, plus one shift per kept unit. Returns whether the
+	// document was accepted; if not, the edit still stands, so that the
+	// next one applies to it, and the last tree stays as it is.
+	bool reparse(size_t start, size_t count, vector<string> &tokens, Change &change) {
+		if (start > lastTokens.size() || count > lastTokens.size() - start) {
+			throw string("ERROR: edit past the end of the document");
+		}
+		size_t added = tokens.size();
+		for (Unit &unit : units) {
+			if (unit.first >= start + count) unit.first += added - count;
+			else if (unit.first + unit.count > start) unit.intact = false;
+		}
+		if (added == count) {
+			std::move(tokens.begin(), tokens.end(), lastTokens.begin() + start);
+		}
+		else {
+			lastTokens.erase(lastTokens.begin() + start, lastTokens.begin() + start + count);
+			lastTokens.insert(lastTokens.begin() + start, make_move_iterator(tokens.begin()), make_move_iterator(tokens.end()));
+		}
+
+		Arena parseArena;
+		current = &parseArena;
+		KeptInput input(*this);
+		auto pushToken = [&](size_t i) {
+			const string &token = lastTokens[i];
+			size_t space = token.find(' ');
+			size_t length = token.size() - space - 1;
+			input.push(makeNode(symbolId(token.substr(0, space)), current->copy(token.data() + space + 1, length), length), i + 1);
+		};
+		input.push(makeNode(WLP4::BOF, "BOF", 3), 0);
+		size_t i = 0;
+		for (const Unit &unit : units) {
+			if (!unit.intact) continue;
+			for (; i < unit.first; i++) pushToken(i);
+			input.push(unit.node, i + 1);
+			i += unit.count;
+		}
+		for (; i < lastTokens.size(); i++) pushToken(i);
+		input.push(makeNode(WLP4::EOF_, "EOF", 3), lastTokens.size() + 1);
+		drive(input);
+		if (!accepted()) return false;
+
+		// procedures derives procedure procedures or main
+		vector<Unit> parsed;
+		uint32_t first = 0;
+		size_t k = 0;
+		for (Node *procedures = symbolStack[1]; ; procedures = procedures->children[1]) {
+			Node *node = procedures->children[0];
+			while (k < units.size() && (!units[k].intact || units[k].first < first)) k++;
+			if (k < units.size() && units[k].node == node) {
+				parsed.push_back(units[k]);
+			}
+			else {
+				shared_ptr<string> text = make_shared<string>();
+				procedures->printLine(*text);
+				node->printNode(*text);
+				size_t bytes = 0;
+				Node *copy = copyTree(node, *unitArena, bytes);
+				unitArenaBytes += bytes;
+				parsed.push_back(Unit{ copy, first, countTokens(node), true, bytes, text });
+			}
+			first += parsed.back().count;
+			if (procedures->numOfChild == 1) break;
+		}
+		size_t front = 0, back = 0;
+		while (front < units.size() && front < parsed.size() && units[front].node == parsed[front].node) front++;
+		while (back < units.size() - front && back < parsed.size() - front &&
+			units[units.size() - 1 - back].node == parsed[parsed.size() - 1 - back].node) back++;
+		change = Change{ front, units.size() - front - back, parsed.size() - front - back };
+		units.swap(parsed);
+
+		size_t liveBytes = 0;
+		for (const Unit &unit : units) liveBytes += unit.bytes;
+		if (unitArenaBytes > 2 * liveBytes) {
+			unique_ptr<Arena> compacted(new Arena);
+			unitArenaBytes = 0;
+			for (Unit &unit : units) unit.node = copyTree(unit.node, *compacted, unitArenaBytes);
+			unitArena.swap(compacted);
+		}
+		return true;
+	}
+
+	// The postorder record of -flat: an entry is the index of a token,
+	// or REDUCED | the rule of a reduction. subtreeSizes holds the
+	// number of entries in the subtree that ends at each one.
+	static const uint32_t REDUCED = 0x80000000;
+	vector<uint32_t> postorder;
+	vector<uint32_t> subtreeSizes;
+	// The tokens of -flat and -j, with the lexemes packed into one
+	// string
+	vector<int8_t> tokenSymbols;
+	vector<uint32_t> lexemeEnds;
+	string lexemes;
+
+	void storeToken(int symbol, const char *lexeme, size_t length) {
+		tokenSymbols.push_back(symbol);
+		lexemes.append(lexeme, length);
+		lexemeEnds.push_back(lexemes.size());
+	}
+	// A Node for packed token i of source
+	Node *makeLeaf(const Lr &source, size_t i) {
+		uint32_t begin = i ? source.lexemeEnds[i - 1] : 0;
+		uint32_t length = source.lexemeEnds[i] - begin;
+		return makeNode(source.tokenSymbols[i], current->copy(source.lexemes.data() + begin, length), length);
+	}
+
+	// Where the procedures and main of the packed tokens are, as
+	// [begin, end) token ranges: each starts with INT ID LPAREN or
+	// INT WAIN LPAREN and ends at the RBRACE that closes its first
+	// LBRACE. The ranges stop at the first place that does not look
+	// like one.
+	vector<pair<size_t, size_t>> splitProcedures() const {
+		vector<pair<size_t, size_t>> spans;
+		// Skip BOF, and never take in EOF
+		size_t i = 1, n = tokenSymbols.size() - 1;
+		while (i + 2 < n && tokenSymbols[i] == WLP4::INT &&
+			(tokenSymbols[i + 1] == WLP4::ID || tokenSymbols[i + 1] == WLP4::WAIN) && tokenSymbols[i + 2] == WLP4::LPAREN) {
+			size_t j = i + 3;
+			int depth = 0;
+			for (; j < n; j++) {
+				if (tokenSymbols[j] == WLP4::LBRACE) depth++;
+				else if (tokenSymbols[j] == WLP4::RBRACE && --depth == 0) break;
+			}
+			if (j == n) break;
+			spans.emplace_back(i, j + 1);
+			i = j + 1;
+		}
+		return spans;
+	}
+
+	// Parses the packed tokens [begin, end) of source as one procedure
+	// or main, from the state after BOF, with token end as the
+	// lookahead that completes it. Returns its node, or null if the
+	// tokens are not exactly one procedure or main.
+	Node *parseProcedure(const Lr &source, size_t begin, size_t end) {
+		// null stands for BOF
+		symbolStack.assign(1, nullptr);
+		stateStack.assign(1, 0);
+		stateStack.push_back(tables.action(0, WLP4::BOF) - 1);
+		for (size_t i = begin; ; i++) {
+			int symbol = source.tokenSymbols[i];
+			int16_t act;
+			while ((act = symbol < 0 ? 0 : tables.action(stateStack.back(), symbol)) < 0) {
+				if (!reduce(-act - 1)) return nullptr;
+				int top = symbolStack.back()->symbol;
+				if (symbolStack.size() == 2 && (top == WLP4::procedure || top == WLP4::main)) {
+					return i == end ? symbolStack.back() : nullptr;
+				}
+			}
+			if (act == 0 || i == end) return nullptr;
+			symbolStack.push_back(makeLeaf(source, i));
+			stateStack.push_back(act - 1);
+		}
+	}
+
+	// Writes the derivation under the start rule whose children are the
+	// postorder entries roots, as parse would: in text, or in the
+	// binary format of wlp4binary.h. The children of an entry are the
+	// subtrees that end right before it, one after the other.
+	void writePreorder(const vector<uint32_t> &roots, bool binary) {
+		string lines[WLP4::NUM_RULES];
+		for (int r = 0; r < WLP4::NUM_RULES; r++) {
+			lines[r] = ruleString(r) + '\n';
+		}
+		string out = binary ? string(WLP4::derivationMagic, sizeof WLP4::derivationMagic) + '\0' : lines[0];
+		vector<uint32_t> pending(roots.rbegin(), roots.rend());
+		while (!pending.empty()) {
+			uint32_t at = pending.back();
+			pending.pop_back();
+			uint32_t entry = postorder[at];
+			if (entry & REDUCED) {
+				int r = entry & ~REDUCED;
+				if (binary) out += static_cast<char>(r);
+				else out += lines[r];
+				uint32_t child = at - 1;
+				for (int i = 0; i < WLP4::rules[r].length; i++) {
+					pending.push_back(child);
+					child -= subtreeSizes[child];
+				}
+			}
+			else {
+				int symbol = tokenSymbols[entry];
+				uint32_t begin = entry ? lexemeEnds[entry - 1] : 0;
+				uint32_t length = lexemeEnds[entry] - begin;
+				if (binary) {
+					out += static_cast<char>(WLP4::LEAF | symbol);
+					if (!WLP4::fixedSpelling(symbol)) {
+						char varint[5];
+						out.append(varint, WLP4::encodeVarint(length, varint));
+						out.append(lexemes, begin, length);
+					}
+				}
+				else {
+					out += WLP4::symbolNames[symbol];
+					if (length != 0) {
+						out += ' ';
+						out.append(lexemes, begin, length);
+					}
+					out += '\n';
+				}
+			}
+			// Hand over big derivations in pieces
+			if (out.size() >= 1 << 16) {
+				cout.write(out.data(), out.size());
+				out.clear();
+			}
+		}
+		cout.write(out.data(), out.size());
+	}
+
+	// Runs the automaton over symbols without building a tree, and
+	// returns the number of table lookups made
+	template <typename Tables>
+	static size_t recognize(const Tables &tables, const vector<int> &symbols, vector<uint16_t> &stateStack) {
+		size_t lookups = 0;
+		stateStack.assign(1, 0);
+		for (size_t next = 0; next < symbols.size(); ) {
+			int16_t act = symbols[next] < 0 ? 0 : tables.action(stateStack.back(), symbols[next]);
+			++lookups;
+			if (act == 0) break;
+			if (act < 0) {
+				const WLP4::Rule &rule = WLP4::rules[-act - 1];
+				stateStack.resize(stateStack.size() - rule.length);
+				int16_t go = tables.go(stateStack.back(), rule.lhs);
+				++lookups;
+				if (go <= 0) break;
+				stateStack.push_back(go - 1);
 			}
-			//cout<<"I am here:"<<totalNumSymbol - inputSymbolStack.size()<<endl;
+			else {
+				stateStack.push_back(act - 1);
+				++next;
+			}
+		}
+		return lookups;
+	}
+
+	// Average time of one lookup when recognizing symbols with tables
+	template <typename Tables>
+	static double timeLookups(const Tables &tables, const vector<int> &symbols) {
+		vector<uint16_t> stateStack;
+		size_t lookups = 0;
+		auto start = chrono::steady_clock::now();
+		chrono::duration<double> elapsed(0);
+		while (elapsed.count() < 0.5) {
+			lookups += recognize(tables, symbols, stateStack);
+			elapsed = chrono::steady_clock::now() - start;
+		}
+		return elapsed.count() * 1e9 / lookups;
+	}
+
+public:
+	// Compares table lookup speed of the compressed tables against the
+	// dense automaton on the given input
+	void benchmark(istream &in) {
+		vector<int> symbols;
+		TokenReader reader(in);
+		while (reader.next()) symbols.push_back(reader.symbol);
+		cout << "dense:  " << sizeof WLP4::action << " bytes, "
+			<< timeLookups(DenseTables(), symbols) << " ns/lookup" << endl;
+		cout << "packed: " << sizeof parseTables << " bytes, "
+			<< timeLookups(parseTables, symbols) << " ns/lookup" << endl;
+	}
+
+	void parse(istream &in, bool binary) {
+		StreamInput input(*this, in);
+		drive(input);
+		printTree(binary);
+	}
+
+	// -j: parses the procedures and main on up to jobs threads, each on
+	// its own from the state after BOF, then runs the automaton over
+	// BOF, their trees and EOF to build the procedures spine. A range
+	// that does not parse on its own goes into that last pass as tokens,
+	// so any error is found and reported as parse would.
+	void parseParallel(istream &in, bool binary, unsigned jobs) {
+		TokenReader reader(in);
+		while (reader.next()) storeToken(reader.symbol, reader.lexeme, reader.length);
+		vector<pair<size_t, size_t>> spans = splitProcedures();
+		vector<Node *> trees(spans.size());
+		if (jobs > spans.size()) jobs = spans.size();
+		// Every worker has its own stacks and Arena, and takes a run of
+		// ranges holding about 1/jobs of their tokens
+		vector<Lr> workers(jobs);
+		vector<std::exception_ptr> errors(jobs);
+		vector<size_t> firstSpan(jobs + 1, spans.size());
+		for (unsigned k = 0; k < jobs; ++k) {
+			size_t start = spans[0].first + (spans.back().second - spans[0].first) / jobs * k;
+			firstSpan[k] = lower_bound(spans.begin(), spans.end(), make_pair(start, size_t(0))) - spans.begin();
 		}
-		//cout<<"I reach here"<<endl;
-		string finalString = "";
-		for (int i = 0; i < symbolStack.size(); i++) {
-			finalString += symbolStack[i]->type;
-			if (i != symbolStack.size() - 1) {
-				finalString += " ";
+		auto work = [&](unsigned k) {
+			try {
+				for (size_t s = firstSpan[k]; s < firstSpan[k + 1]; s++) {
+					trees[s] = workers[k].parseProcedure(*this, spans[s].first, spans[s].second);
+				}
+			}
+			catch (...) {
+				errors[k] = std::current_exception();
 			}
+		};
+		// The calling thread takes the first run itself
+		vector<std::thread> threads;
+		for (unsigned k = 1; k < jobs; ++k) threads.push_back(std::thread(work, k));
+		if (jobs) work(0);
+		for (size_t k = 0; k < threads.size(); ++k) threads[k].join();
+		for (unsigned k = 0; k < jobs; ++k) {
+			if (errors[k]) std::rethrow_exception(errors[k]);
 		}
 
-		if (finalString == finalSymbolStack) {
+		KeptInput input(*this);
+		size_t next = 0;
+		for (size_t s = 0; s < spans.size(); s++) {
+			if (!trees[s]) continue;
+			for (; next < spans[s].first; next++) input.push(makeLeaf(*this, next), next);
+			input.push(trees[s], next);
+			next = spans[s].second;
+		}
+		for (; next < tokenSymbols.size(); next++) input.push(makeLeaf(*this, next), next);
+		drive(input);
+		printTree(binary);
+	}
+
+	// Prints the derivation of the tree drive built, if it was accepted
+	void printTree(bool binary) {
+		if (accepted()) {
 			// accept, printout the rules used:
-			cout<<initialRule<<endl;
-			for (int i = 0; i < symbolStack.size(); i++) {
-				symbolStack[i]->printNode();
+			if (binary) {
+				writeDerivation(symbolStack.data(), symbolStack.size());
+				return;
+			}
+			printDerivation();
+		}
+	}
+
+	// Prints the derivation of an accepted tree in preorder, writing it
+	// out a procedure at a time
+	void printDerivation() {
+		string out = ruleString(0);
+		out += '\n';
+		symbolStack[0]->printNode(out);
+		for (const Node *procedures = symbolStack[1]; ; procedures = procedures->children[1]) {
+			procedures->printLine(out);
+			procedures->children[0]->printNode(out);
+			cout.write(out.data(), out.size());
+			out.clear();
+			if (procedures->numOfChild == 1) break;
+		}
+		symbolStack[2]->printNode(out);
+		cout.write(out.data(), out.size());
+	}
+
+	// -flat: prints the same derivation as parse without building the
+	// tree. Each shift and reduction is recorded in postorder, a few
+	// bytes apiece, and the preorder listing is read back from that.
+	void parseFlat(istream &in, bool binary) {
+		TokenReader reader(in);
+		// The postorder entry of each symbol on the stack
+		vector<uint32_t> roots;
+		stateStack.assign(1, 0);
+		// next is the index of the lookahead token, which is only
+		// stored once it is shifted
+		size_t next = 0;
+		for (bool more = reader.next(); more; ) {
+			int symbol = reader.symbol;
+			int16_t act = symbol < 0 ? 0 : tables.action(stateStack.back(), symbol);
+			if (act == 0) {
+				throw string("ERROR at " + to_string(next));
+			}
+			if (act < 0) {
+				const WLP4::Rule &rule = WLP4::rules[-act - 1];
+				uint32_t size = 1;
+				for (int i = 1; i <= rule.length; i++) {
+					size += subtreeSizes[roots[roots.size() - i]];
+				}
+				roots.resize(roots.size() - rule.length);
+				stateStack.resize(stateStack.size() - rule.length);
+				int16_t go = tables.go(stateStack.back(), rule.lhs);
+				if (go <= 0) {
+					throw string("ERROR at " + to_string(next - 1));
+				}
+				roots.push_back(postorder.size());
+				postorder.push_back(REDUCED | (-act - 1));
+				subtreeSizes.push_back(size);
+				stateStack.push_back(go - 1);
+			}
+			else {
+				storeToken(symbol, reader.lexeme, reader.length);
+				roots.push_back(postorder.size());
+				postorder.push_back(next);
+				subtreeSizes.push_back(1);
+				stateStack.push_back(act - 1);
+				++next;
+				more = reader.next();
+			}
+		}
+		// Shifting the last token, EOF, leaves BOF procedures EOF
+		writePreorder(roots, binary);
+	}
+
+	// -watch: keeps a document of tokens up to date under a series of
+	// edits and prints how the derivation changes with each. An edit is
+	// a line "start count", the tokens that replace count tokens of the
+	// document from start on (counted from 0, in the text format) and an
+	// empty line; the document starts out empty. Its reply is a line
+	// "first removed added" and the lines of the added procedures, then
+	// an empty line: removed procedures of the last derivation printed,
+	// from the first on, were replaced by these added ones. Each
+	// procedure (and main) has its link in the procedures spine as its
+	// first line, so the derivation is the start rule, BOF BOF, the lines
+	// of every procedure in order and EOF EOF. An edit that does not parse
+	// gets only the empty line, with the error on stderr.
+	// An edit is parsed against the last derivation (see reparse), so
+	// its cost grows with the procedures it touches and the number of
+	// procedures, not with the size of the document.
+	void watch(istream &in) {
+		string line;
+		while (getline(in, line)) {
+			if (line.find_first_not_of(" \t\n") == string::npos) continue;
+			// The header, two integers split as strtoul sees them
+			const char *p = line.c_str();
+			char *end;
+			size_t start = strtoul(p, &end, 10);
+			bool valid = end != p;
+			p = end;
+			size_t count = strtoul(p, &end, 10);
+			valid = valid && end != p;
+			while (isspace(static_cast<unsigned char>(*end))) end++;
+			valid = valid && *end == '\0';
+			vector<string> tokens;
+			while (getline(in, line)) {
+				if (line.find_first_not_of(" \t\n") == string::npos) break;
+				// "type lexeme", split at whitespace as >> would
+				p = line.c_str();
+				while (isspace(static_cast<unsigned char>(*p))) p++;
+				const char *type = p;
+				while (*p && !isspace(static_cast<unsigned char>(*p))) p++;
+				tokens.emplace_back(type, p - type);
+				while (isspace(static_cast<unsigned char>(*p))) p++;
+				const char *lexeme = p;
+				while (*p && !isspace(static_cast<unsigned char>(*p))) p++;
+				tokens.back() += ' ';
+				tokens.back().append(lexeme, p - lexeme);
+			}
+			try {
+				if (!valid) throw string("ERROR: an edit starts with a line \"start count\"");
+				Change change;
+				if (reparse(start, count, tokens, change)) {
+					string out = to_string(change.first) + ' ' + to_string(change.removed) + ' ' + to_string(change.added) + '\n';
+					for (size_t i = change.first; i < change.first + change.added; i++) {
+						out += *units[i].text;
+					}
+					cout.write(out.data(), out.size());
+				}
+			}
+			catch (const string &msg) {
+				std::cerr << msg << endl;
 			}
+			current = &arena;
+			// The one flush of the reply
+			cout << endl;
 		}
 	}
 
@@ -313,24 +1082,18 @@ public:
 		string line;
 		while (getline(in, line)) {
 			istringstream iss(line);
-			string state;
+			int state;
 			string input;
 			iss >> state;
 			iss >> input;
-			if (transfer.find(state + " " + input) != transfer.end()) {
-				string candidate = transfer[state + " " + input];
-				string action = candidate.substr(0, candidate.find(" "));
-				if (action == "reduce") {
-					// we need to get which rule we are using
-					string numOfRule = candidate.substr(candidate.find(" ") + 1, candidate.length() - candidate.find(" ") - 1);
-					istringstream buffer(numOfRule);
-					int num;
-					buffer >> num;
-					cout << "reduce " << rules[num] << endl;
-				}
-				else {
-					cout << candidate << endl;
-				}
+			int symbol = symbolId(input);
+			int16_t act = symbol < 0 ? 0 : action[state][symbol];
+			if (act < 0) {
+				// we need to get which rule we are using
+				cout << "reduce " << ruleString(-act - 1) << endl;
+			}
+			else if (act > 0) {
+				cout << "shift " << act - 1 << endl;
 			}
 			else {
 				cout << "error" << endl;
@@ -339,12 +1102,65 @@ public:
 	}
 };
 
+// The N of -j N, a non-negative integer; 0 means one thread per core
+static unsigned jobCount(const char *arg) {
+	char *end;
+	errno = 0;
+	unsigned long n = strtoul(arg, &end, 10);
+	if (*arg < '0' || *arg > '9' || *end != '\0' || errno == ERANGE || n > UINT_MAX) {
+		throw string("ERROR: -j takes a non-negative integer, not ") + arg;
+	}
+	if (n == 0) return std::max(1u, std::thread::hardware_concurrency());
+	return n;
+}
+
 // Reads a .cfg file and prints the left-canonical
 // derivation without leading or trailing spaces.
-int main() {
+// -b prints the derivation in the binary format of wlp4binary.h, which
+// wlp4gen recognizes by its magic number.
+// -bench times the parse table lookups on the input instead, for the
+// compressed tables and the dense automaton.
+// -watch applies a series of edits to a token stream, printing which
+// procedures of the derivation each one changes (see Lr::watch).
+// -flat prints the derivation without building the parse tree; it can
+// be combined with -b.
+// -j N parses the procedures with N threads (0 for one per core); it
+// has no effect together with -flat.
+int main(int argc, char *argv[]) {
 	try {
+		bool binary = false, flat = false;
+		unsigned jobs = 1;
+		string option;
+		for (int i = 1; i < argc; i++) {
+			string arg = argv[i];
+			if (arg == "-b") binary = true;
+			else if (arg == "-flat") flat = true;
+			else if (arg == "-j") {
+				if (i + 1 == argc) throw string("ERROR: -j takes a number of threads");
+				jobs = jobCount(argv[++i]);
+			}
+			else if (arg == "-bench" || arg == "-watch") option = arg;
+			else if (arg[0] == '-') throw "ERROR: unknown option " + arg;
+			else throw "ERROR: unexpected argument " + arg + ", the input is read from stdin";
+		}
 		Lr languageMachine;
-		languageMachine.parse(std::cin);
+		if (option == "-bench") {
+			languageMachine.benchmark(std::cin);
+			return 0;
+		}
+		if (option == "-watch") {
+			languageMachine.watch(std::cin);
+			return 0;
+		}
+		if (flat) {
+			languageMachine.parseFlat(std::cin, binary);
+			return 0;
+		}
+		if (jobs > 1) {
+			languageMachine.parseParallel(std::cin, binary, jobs);
+			return 0;
+		}
+		languageMachine.parse(std::cin, binary);
 	}
 	catch (const string& msg) {
 		// If an exception occurs print the message and end the program
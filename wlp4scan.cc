@@ -2,8 +2,26 @@
 #include <string>
 #include <iostream>
 #include <sstream>
-#include <map>
 #include <set>
+#include <memory>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "dfa.h"
+#include "simdscan.h"
+#include "tokenstream.h"
+#include "intparse.h"
+#include "wlp4binary.h"
 // Use only the neeeded aspects of each namespace
 using std::string;
 using std::vector;
@@ -161,267 +179,566 @@ namespace{
 		"NULL"
 	};
 
-	// A Token class representing the concrete functions we
-	// might want to apply to a wlp4 Token
-	
+	// The grammar terminal of each kind that is ever emitted, for the
+	// binary token format
+	const WLP4::Terminal kindTerminals[] = {
+		WLP4::ID,           // KEYWORD_OR_ID (never emitted)
+		WLP4::NUM,
+		WLP4::LPAREN,
+		WLP4::RPAREN,
+		WLP4::LBRACE,
+		WLP4::RBRACE,
+		WLP4::BECOMES,
+		WLP4::EQ,
+		WLP4::NE,
+		WLP4::LT,
+		WLP4::GT,
+		WLP4::LE,
+		WLP4::GE,
+		WLP4::PLUS,
+		WLP4::MINUS,
+		WLP4::STAR,
+		WLP4::SLASH,
+		WLP4::PCT,
+		WLP4::COMMA,
+		WLP4::SEMI,
+		WLP4::LBRACK,
+		WLP4::RBRACK,
+		WLP4::AMP,
+		WLP4::ID,           // ERR (never emitted)
+		WLP4::ID,           // WHITESPACE (never emitted)
+		WLP4::ID,
+		WLP4::IF,
+		WLP4::RETURN,
+		WLP4::ELSE,
+		WLP4::WHILE,
+		WLP4::PRINTLN,
+		WLP4::WAIN,
+		WLP4::INT,
+		WLP4::NEW,
+		WLP4::DELETE,
+		WLP4::NULL_
+	};
 
-	class Token {
-	protected:
-		// The kind of the Token
+	// The keywords of wlp4. They are told apart from other identifiers
+	// by a perfect hash on the length and the first and last characters,
+	// so recognizing one costs a table probe and one comparison
+	struct Keyword {
+		const char *text;
+		unsigned length;
 		Kind kind;
-		// The actual string representing the Token
-		std::string lexeme;
-	public:
-		static Token* makeToken(Kind kind, std::string lexeme);
-		Token(Kind kind, std::string lexeme) : kind(kind), lexeme(lexeme) {}
-		// Convenience functions for operations we might like to
-		// use on a Token
-		std::string toString() const {
-			return kindStrings[kind];
-		}
-		std::string getLexeme() const {
-			return lexeme;
-		}
-		Kind getKind() const {
-			return kind;
-		}
 	};
 
-	class NumToken : public Token{
-	  public:
-	    NumToken(Kind kind, std::string lexeme);
+	constexpr Keyword keywords[] = {
+		{ "if", 2, IF },
+		{ "return", 6, RETURN },
+		{ "else", 4, ELSE },
+		{ "while", 5, WHILE },
+		{ "println", 7, PRINTLN },
+		{ "wain", 4, WAIN },
+		{ "int", 3, INT },
+		{ "new", 3, NEW },
+		{ "delete", 6, DELETE },
+		{ "NULL", 4, Null }
 	};
+	constexpr int numKeywords = sizeof(keywords) / sizeof(keywords[0]);
+	constexpr int keywordSlots = 16;
 
-	Token* Token::makeToken(Kind kind, std::string lexeme) {
-			switch (kind) {
-			case NUM:
-				return new NumToken(kind, lexeme);
-			default:
-				return new Token(kind, lexeme);
-			}
+	constexpr unsigned keywordHash(const char *s, unsigned length) {
+		return (length * 5 + static_cast<unsigned char>(s[0]) * 3
+			+ static_cast<unsigned char>(s[length - 1])) % keywordSlots;
 	}
 
-	template <typename T>
-	T fromString(const string& s, bool hex = false) {
-		istringstream iss (s);
-		T n;
-		if (hex)
-			iss >> std::hex;
-		if (iss >> n)
-			return n;
-		else
-			throw string("ERROR: Type not convertible from string.");
+	// slot[h] is the index of the keyword whose hash is h, or -1
+	struct KeywordTable {
+		int slot[keywordSlots];
+		constexpr KeywordTable() : slot{} {
+			for (int i = 0; i < keywordSlots; ++i) slot[i] = -1;
+			for (int k = 0; k < numKeywords; ++k)
+				slot[keywordHash(keywords[k].text, keywords[k].length)] = k;
+		}
+		// True when no two keywords share a slot
+		constexpr bool perfect() const {
+			for (int k = 0; k < numKeywords; ++k)
+				if (slot[keywordHash(keywords[k].text, keywords[k].length)] != k) return false;
+			return true;
+		}
+	};
+
+	constexpr KeywordTable keywordTable;
+	static_assert(keywordTable.perfect(), "keyword hash has collisions");
+
+	// The Kind of the identifier of the given length starting at s
+	Kind keywordOrId(const char *s, unsigned length) {
+		if (length < 2 || length > 7) return ID;
+		int k = keywordTable.slot[keywordHash(s, length)];
+		if (k >= 0 && keywords[k].length == length && memcmp(keywords[k].text, s, length) == 0)
+			return keywords[k].kind;
+		return ID;
 	}
 
-	NumToken::NumToken(Kind kind, std::string lexeme) : Token(kind, lexeme) {
-		if(lexeme.length() > 1 && lexeme[0]=='0') throw "ERROR: illegal number: "+ lexeme;
-		long long l = fromString<long long>(lexeme);
+	// Tokens are kept in a Scan::TokenStream: a Token is an index into
+	// parallel arrays, and its lexeme is a view (offset and length) into
+	// the source buffer that was scanned, so making one never allocates
+	using Scan::TokenStream;
+
+	// Numbers are checked and decoded once, when they are scanned;
+	// [begin, end) holds only digits
+	long long checkNum(const char *begin, const char *end) {
+		if (end - begin > 1 && *begin == '0') throw "ERROR: illegal number: " + string(begin, end);
+		uint64_t l;
+		// As when this was read with an istringstream, anything that
+		// does not fit in a long long is not convertible at all
+		if (!Scan::decimalValue(begin, end, INT64_MAX, l))
+			throw string("ERROR: Type not convertible from string.");
 		if (l > 2147483647)
-			throw string("ERROR: Numeric literal out of range: " + lexeme);
+			throw string("ERROR: Numeric literal out of range: " + string(begin, end));
+		return l;
 	}
 
-	std::ostream& operator<<(std::ostream& out, const Token& t) {
-		out << t.toString() << " " << t.getLexeme();
-		return out;
+	// A large userspace buffer in front of standard output, so that
+	// printing a Token is a copy rather than a write system call
+	class Output {
+		static const size_t capacity = 1 << 20;
+		std::unique_ptr<char[]> buffer;
+		size_t used;
+		Output(const Output&);
+		Output& operator=(const Output&);
+	public:
+		Output() : buffer(new char[capacity]), used(0) {}
+		~Output() {
+			flush();
+		}
+		void put(const char *data, size_t length) {
+			if (used + length > capacity) {
+				flush();
+				if (length > capacity) {
+					writeAll(data, length);
+					return;
+				}
+			}
+			memcpy(buffer.get() + used, data, length);
+			used += length;
+		}
+		void put(const string &s) {
+			put(s.data(), s.size());
+		}
+		void put(char c) {
+			if (used == capacity) flush();
+			buffer[used++] = c;
+		}
+		void flush() {
+			writeAll(buffer.get(), used);
+			used = 0;
+		}
+	private:
+		static void writeAll(const char *data, size_t length) {
+			while (length > 0) {
+				ssize_t n = write(STDOUT_FILENO, data, length);
+				if (n < 0) {
+					if (errno == EINTR) continue;
+					return;
+				}
+				data += n;
+				length -= n;
+			}
+		}
+	};
+
+	// Print Token i in the "KIND lexeme" form, taking the lexeme
+	// straight out of the source it points into
+	void printToken(Output& out, const char *source, const TokenStream& tokens, size_t i) {
+		out.put(kindStrings[tokens.kind(i)]);
+		out.put(' ');
+		out.put(source + tokens.offset(i), tokens.length(i));
+		out.put('\n');
 	}
 
-	class Lexer {
-		std::map<std::string, Kind> keyWordKinds;
-		const string whitespace = "\t\n ";
-		const string letters = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
-		const string digits = "0123456789";
-		const string oneToNine = "123456789";
-		// At most 21 states and 256 transitions (max number of characters in ASCII)
-		static const int maxStates = 28;
-		static const int maxTrans = 256;
-		// Transition function
-		State delta[maxStates][maxTrans];
-		// Private method to set the transitions based upon characters in the
-		// given string
-		void setTrans(State from, const std::string& chars, State to) {
-			for (string::const_iterator it = chars.begin(); it != chars.end(); ++it)
-				delta[from][static_cast<unsigned int>(*it)] = to;
+	// Write Token i in the binary format of wlp4binary.h
+	void writeToken(Output& out, const char *source, const TokenStream& tokens, size_t i) {
+		WLP4::Terminal terminal = kindTerminals[tokens.kind(i)];
+		out.put(static_cast<char>(terminal));
+		if (WLP4::hasLexeme(terminal)) {
+			char length[5];
+			out.put(length, WLP4::encodeVarint(tokens.length(i), length));
+			out.put(source + tokens.offset(i), tokens.length(i));
 		}
+	}
+
+	// How Tokens are written to standard output
+	typedef void (*TokenPrinter)(Output&, const char *, const TokenStream&, size_t);
+
+	// A read-only view of the whole input. A named file is memory-mapped so
+	// that Tokens can point straight into the page cache; standard input
+	// cannot be mapped in general, so it is read into a buffer instead.
+	class Source {
+		const char *data;
+		size_t size;
+		void *mapping;
+		string buffer;
+		// Not copyable, the mapping is unmapped exactly once
+		Source(const Source&);
+		Source& operator=(const Source&);
 	public:
-		Lexer() {
-			keyWordKinds["if"] = IF;
-			keyWordKinds["return"] = RETURN;
-			keyWordKinds["else"] = ELSE;
-			keyWordKinds["while"] = WHILE;
-			keyWordKinds["println"] = PRINTLN;
-			keyWordKinds["wain"] = WAIN;
-			keyWordKinds["int"] = INT;
-			keyWordKinds["new"] = NEW;
-			keyWordKinds["delete"] = DELETE;
-			keyWordKinds["NULL"] = Null;
-			// Set default transitions to the Error state
-			for (int i = 0; i < maxStates; ++i) {
-				for (int j = 0; j < maxTrans; ++j) {
-					delta[i][j] = ST_ERR;
+		// Read all of standard input
+		Source() : data(nullptr), size(0), mapping(nullptr) {
+			char chunk[65536];
+			size_t n;
+			while ((n = fread(chunk, 1, sizeof chunk, stdin)) > 0)
+				buffer.append(chunk, n);
+			data = buffer.data();
+			size = buffer.size();
+		}
+		// Map the named file
+		explicit Source(const string &fileName) : data(nullptr), size(0), mapping(nullptr) {
+			int fd = open(fileName.c_str(), O_RDONLY);
+			if (fd < 0) throw string("ERROR: cannot open " + fileName);
+			struct stat st;
+			if (fstat(fd, &st) < 0) {
+				close(fd);
+				throw string("ERROR: cannot read " + fileName);
+			}
+			size = st.st_size;
+			if (size > 0) {
+				mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+				if (mapping == MAP_FAILED) {
+					close(fd);
+					throw string("ERROR: cannot map " + fileName);
 				}
+				// The scanner makes a single forward pass over the file
+				madvise(mapping, size, MADV_SEQUENTIAL);
+				data = static_cast<const char *>(mapping);
 			}
-			// Change transitions as appropriate for the MIPS recognizer
-			setTrans(ST_START, whitespace, ST_WHITESPACE);
-			setTrans(ST_WHITESPACE, whitespace, ST_WHITESPACE);
-			setTrans(ST_START, digits, ST_NUM);
-			setTrans(ST_NUM, digits, ST_NUM);
-			setTrans(ST_START, letters, ST_KEYWORD_OR_ID);
-			setTrans(ST_KEYWORD_OR_ID, letters + digits, ST_KEYWORD_OR_ID);
-			setTrans(ST_START, "(", ST_LPAREN);
-			setTrans(ST_START, ")", ST_RPAREN);
-			setTrans(ST_START, "{", ST_LBRACE);
-			setTrans(ST_START, "}", ST_RBRACE);
-			setTrans(ST_START, "=", ST_BECOMES);
-			setTrans(ST_BECOMES, "=", ST_EQ);
-			setTrans(ST_START, "!", ST_NOT);
-			setTrans(ST_NOT, "=", ST_NE);
-			setTrans(ST_START, "<", ST_LT);
-			setTrans(ST_LT, "=", ST_LE);
-			setTrans(ST_START, ">", ST_GT);
-			setTrans(ST_GT, "=", ST_GE);
-			setTrans(ST_START, "+", ST_PLUS);
-			setTrans(ST_START, "-", ST_MINUS);
-			setTrans(ST_START, "*", ST_STAR);
-			setTrans(ST_START, "/", ST_SLASH);
-			setTrans(ST_SLASH, "/", ST_COMMENT);
-			setTrans(ST_START, "%", ST_PCT);
-			setTrans(ST_START, ",", ST_COMMA);
-			setTrans(ST_START, ";", ST_SEMI);
-			setTrans(ST_START, "[", ST_LBRACK);
-			setTrans(ST_START, "]", ST_RBRACK);
-			setTrans(ST_START, "&", ST_AMP);
-
-			// A comment can only ever lead to the comment state
-			for (int j = 0; j < maxTrans; ++j) delta[ST_COMMENT][j] = ST_COMMENT;
+			close(fd);
 		}
-			// Output a vector of Tokens representing the Tokens present in the
-			// given line
-		std::vector<Token*> scan(const std::string& line);
+		~Source() {
+			if (mapping) munmap(mapping, size);
+		}
+		const char *begin() const {
+			return data;
+		}
+		const char *end() const {
+			return data + size;
+		}
+	};
+
+	// Character sets used by the transition function
+	constexpr const char *whitespace = "\t\n ";
+	constexpr const char *letters = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+	constexpr const char *lettersAndDigits = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
+	constexpr const char *digits = "0123456789";
+
+	// The transition function of the wlp4 recognizer
+	constexpr Scan::DfaRule transitions[] = {
+		{ ST_START, whitespace, ST_WHITESPACE },
+		{ ST_WHITESPACE, whitespace, ST_WHITESPACE },
+		{ ST_START, digits, ST_NUM },
+		{ ST_NUM, digits, ST_NUM },
+		{ ST_START, letters, ST_KEYWORD_OR_ID },
+		{ ST_KEYWORD_OR_ID, lettersAndDigits, ST_KEYWORD_OR_ID },
+		{ ST_START, "(", ST_LPAREN },
+		{ ST_START, ")", ST_RPAREN },
+		{ ST_START, "{", ST_LBRACE },
+		{ ST_START, "}", ST_RBRACE },
+		{ ST_START, "=", ST_BECOMES },
+		{ ST_BECOMES, "=", ST_EQ },
+		{ ST_START, "!", ST_NOT },
+		{ ST_NOT, "=", ST_NE },
+		{ ST_START, "<", ST_LT },
+		{ ST_LT, "=", ST_LE },
+		{ ST_START, ">", ST_GT },
+		{ ST_GT, "=", ST_GE },
+		{ ST_START, "+", ST_PLUS },
+		{ ST_START, "-", ST_MINUS },
+		{ ST_START, "*", ST_STAR },
+		{ ST_START, "/", ST_SLASH },
+		{ ST_SLASH, "/", ST_COMMENT },
+		{ ST_START, "%", ST_PCT },
+		{ ST_START, ",", ST_COMMA },
+		{ ST_START, ";", ST_SEMI },
+		{ ST_START, "[", ST_LBRACK },
+		{ ST_START, "]", ST_RBRACK },
+		{ ST_START, "&", ST_AMP },
+		// A comment can only ever lead to the comment state
+		{ ST_COMMENT, nullptr, ST_COMMENT }
 	};
 
-	vector<Token*> Lexer::scan(const string& line) {
+	constexpr int numStates = ST_COMMENT + 1;
+	constexpr Scan::Dfa<numStates, Scan::countClasses(transitions)> dfa(transitions);
+
+	// These states loop on themselves, so the rest of the run can
+	// be skipped in bulk; a comment runs to the end of the line
+	const char *skipRun(uint8_t state, const char *p, const char *end) {
+		switch (state) {
+		case ST_WHITESPACE:
+			return Scan::skipRun<Scan::Whitespace>(p, end);
+		case ST_KEYWORD_OR_ID:
+			return Scan::skipRun<Scan::AlphaNum>(p, end);
+		case ST_NUM:
+			return Scan::skipRun<Scan::Digits>(p, end);
+		case ST_COMMENT:
+			return end;
+		default:
+			return p;
+		}
+	}
+
+	// The wlp4 recognizer, an instance of the shared DFA engine
+	class Lexer {
+	public:
+		// Append the Tokens present in the line [begin, end) of source,
+		// whose index is line, to tokens
+		void scan(const char *source, const char *begin, const char *end, unsigned line, TokenStream& tokens);
+	};
+
+	void Lexer::scan(const char *source, const char *begin, const char *end, unsigned line, TokenStream& tokens) {
 		int attention1 = 0;
 		int attention2 = 0;
-		// Return vector
-		vector<Token*> ret;
-		if (line.size() == 0) return ret;
-		// Always begin at the start state
-		State currState = ST_START;
-		// startIter represents the beginning of the next Token
-		// that is to be recognized. Initially, this is the beginning
-		// of the line.
-		// Use a const_iterator since we cannot change the input line
-		string::const_iterator startIter = line.begin();
-		// Loop over the the line
-		for (string::const_iterator it = line.begin();;) {
-			// Assume the next state is the error state
-			State nextState = ST_ERR;
-			// If we aren't done then get the transition from the current
-			// state to the next state based upon the current character of
-			//input
-			if (it != line.end())
-				nextState = delta[currState][static_cast<unsigned int>(*it)];
-			// If there is no valid transition then we have reach then end of a
-			// Token and can add a new Token to the return vector
-			if (ST_ERR == nextState) {
-				// Get the kind corresponding to the current state
-				Kind currKind = stateKinds[currState];
-				// If we are in an Error state then we have reached an invalid
-				// Token - so we throw and error and delete the Tokens parsed
-				// thus far
-				if (ERR == currKind) {
-					vector<Token*>::iterator vit;
-					for (vit = ret.begin(); vit != ret.end(); ++vit)
-						delete *vit;
-					throw string("ERROR in lexing after reading " + string(line.begin(), it));
+		// Recognize one Token at a time, each starting at the start state
+		for (const char *startIter = begin; startIter != end;) {
+			uint8_t currState = ST_START;
+			// it is where the longest match starting at startIter ends
+			const char *it = dfa.munch(startIter, end, currState, skipRun);
+			// Get the kind corresponding to the state the match ended in
+			Kind currKind = stateKinds[currState];
+			// If we are in an Error state then we have reached an invalid
+			// Token - so we throw and error
+			if (ERR == currKind) {
+				throw string("ERROR in lexing after reading " + string(begin, it));
+			}
+			unsigned offset = startIter - source;
+			unsigned length = it - startIter;
+			// If we are not in Whitespace then we push back a new token
+			// based upon the kind of the State we end in
+			// Whitespace is ignored for practical purposes
+			if (WHITESPACE != currKind) {
+				
+				if (currKind == KEYWORD_OR_ID) {
+					attention1 += 1;
+					attention2 -= 1;
+					tokens.push(keywordOrId(startIter, length), offset, length, 0, line);
 				}
-				// If we are not in Whitespace then we push back a new token
-				// based upon the kind of the State we end in
-				// Whitespace is ignored for practical purposes
-				if (WHITESPACE != currKind) {
-					
-					if (currKind == KEYWORD_OR_ID) {
-						attention1 += 1;
-						attention2 -= 1;
-						string tokenString = string(startIter, it);
-						std::map<std::string, Kind>::iterator itr = keyWordKinds.find(tokenString);
-						if (itr != keyWordKinds.end()) {
-
-							ret.push_back(Token::makeToken(itr->second, tokenString));
-						}
-						else {
-							ret.push_back(Token::makeToken(ID, tokenString));
-						}
-					}
+				else {
+					if(seperateSet2.find(currKind) != seperateSet2.end()) {attention2 += 1; attention1 -= 1;}
 					else {
-						if(seperateSet2.find(currKind) != seperateSet2.end()) {attention2 += 1; attention1 -= 1;}
-						else {
-							attention2 -= 1;
-							if(seperateSet1.find(currKind) != seperateSet1.end()) attention1+=1;
-							else attention1 -=1;
-						}
-						ret.push_back(Token::makeToken(currKind, string(startIter, it)));
+						attention2 -= 1;
+						if(seperateSet1.find(currKind) != seperateSet1.end()) attention1+=1;
+						else attention1 -=1;
 					}
-				}else{
-					attention1 = 0;
-					attention2 = 0;
+					long long value = 0;
+					if (currKind == NUM) value = checkNum(startIter, it);
+					tokens.push(currKind, offset, length, value, line);
 				}
-				if(attention1 < 0) attention1 =0;
-				if(attention2 < 0) attention2 =0;
-				if(attention1 > 1 || attention2 > 1) throw string("ERROR: two token should be seperated, but together now");
-				// Start of next Token begins here
-				startIter = it;
-				// Revert to start state to begin recognizing next token
-				currState = ST_START;
-				if (it == line.end()) break;
+			}else{
+				attention1 = 0;
+				attention2 = 0;
+			}
+			if(attention1 < 0) attention1 =0;
+			if(attention2 < 0) attention2 =0;
+			if(attention1 > 1 || attention2 > 1) throw string("ERROR: two token should be seperated, but together now");
+			// Start of next Token begins here
+			startIter = it;
+		}
+	}
+
+	// Scan the lines in [begin, end) of source one at a time; no Token
+	// spans a newline. Returns the number of lines scanned.
+	unsigned scanLines(Lexer &lexer, const char *source, const char *begin, const char *end, TokenStream& tokens) {
+		unsigned lineNo = 0;
+		for (const char *line = begin; line < end; ++lineNo) {
+			const char *eol = static_cast<const char *>(memchr(line, '\n', end - line));
+			if (!eol) eol = end;
+			lexer.scan(source, line, eol, lineNo, tokens);
+			line = eol + 1;
+		}
+		return lineNo;
+	}
+
+	void scanSource(Lexer &lexer, const Source &source, TokenStream& tokens) {
+		scanLines(lexer, source.begin(), source.begin(), source.end(), tokens);
+	}
+
+	// Below this many bytes per chunk, starting a thread costs more
+	// than it saves
+	const size_t minChunkSize = 1 << 16;
+
+	// The Tokens and line count of one chunk of a parallel scan, or the
+	// error that stopped it
+	struct Chunk {
+		const char *begin;
+		const char *end;
+		TokenStream tokens;
+		unsigned lines;
+		std::exception_ptr error;
+		Chunk() : begin(nullptr), end(nullptr), lines(0) {}
+	};
+
+	void scanChunk(Lexer &lexer, const char *source, Chunk &chunk) {
+		try {
+			chunk.lines = scanLines(lexer, source, chunk.begin, chunk.end, chunk.tokens);
+		}
+		catch (...) {
+			chunk.error = std::current_exception();
+		}
+	}
+
+	// Scan the source with up to jobs threads. The source is cut into
+	// chunks at line boundaries, and since every line is scanned on its
+	// own (the attention1/attention2 separation check starts afresh on
+	// each line) a chunk needs nothing from the one before it. The
+	// chunks' Tokens are concatenated in order, so the result is the same
+	// as scanSource's; if any chunk fails, the error of the first failing
+	// chunk is the one a sequential scan would have hit first.
+	void scanParallel(Lexer &lexer, const Source &source, TokenStream& tokens, unsigned jobs) {
+		const char *begin = source.begin();
+		const char *end = source.end();
+		size_t size = end - begin;
+		if (jobs > size / minChunkSize) jobs = size / minChunkSize;
+		if (jobs <= 1) {
+			scanSource(lexer, source, tokens);
+			return;
+		}
+		std::unique_ptr<Chunk[]> chunks(new Chunk[jobs]);
+		const char *chunkBegin = begin;
+		for (unsigned k = 0; k < jobs; ++k) {
+			const char *chunkEnd = end;
+			if (k + 1 < jobs) {
+				chunkEnd = std::max(chunkBegin, begin + size / jobs * (k + 1));
+				const char *eol = static_cast<const char *>(memchr(chunkEnd, '\n', end - chunkEnd));
+				chunkEnd = eol ? eol + 1 : end;
 			}
-			else {
-				// Otherwise we proceed to the next state and increment the iterator
-				currState = nextState;
-				++it;
+			chunks[k].begin = chunkBegin;
+			chunks[k].end = chunkEnd;
+			chunkBegin = chunkEnd;
+		}
+		// The calling thread takes the first chunk itself
+		vector<std::thread> workers;
+		for (unsigned k = 1; k < jobs; ++k)
+			workers.push_back(std::thread(scanChunk, std::ref(lexer), begin, std::ref(chunks[k])));
+		scanChunk(lexer, begin, chunks[0]);
+		for (size_t k = 0; k < workers.size(); ++k)
+			workers[k].join();
+
+		unsigned lineBase = 0;
+		for (unsigned k = 0; k < jobs; ++k) {
+			if (chunks[k].error) std::rethrow_exception(chunks[k].error);
+			tokens.append(chunks[k].tokens, lineBase);
+			lineBase += chunks[k].lines;
+		}
+	}
+
+	// Scan the file descriptor fd one block at a time, printing the
+	// Tokens of every complete line as soon as the line is scanned.
+	// Only the current block and its Tokens are held in memory, so
+	// memory use does not grow with the input; the buffer only grows
+	// for a single line longer than it.
+	void streamSource(Lexer &lexer, int fd, Output &out, TokenPrinter print) {
+		vector<char> buffer(1 << 16);
+		size_t filled = 0;
+		unsigned lineNo = 0;
+		TokenStream tokens;
+		for (bool eof = false; !eof;) {
+			if (filled == buffer.size()) buffer.resize(2 * buffer.size());
+			ssize_t n = read(fd, &buffer[filled], buffer.size() - filled);
+			if (n < 0) {
+				if (errno == EINTR) continue;
+				throw string("ERROR: cannot read input");
 			}
+			eof = n == 0;
+			filled += n;
+			const char *begin = buffer.data();
+			const char *end = begin + filled;
+			const char *line = begin;
+			while (line < end) {
+				const char *eol = static_cast<const char *>(memchr(line, '\n', end - line));
+				// A partial line waits for the next block, unless
+				// it is the last line of the input
+				if (!eol && !eof) break;
+				if (!eol) eol = end;
+				lexer.scan(begin, line, eol, lineNo++, tokens);
+				for (size_t i = 0; i < tokens.size(); ++i)
+					print(out, begin, tokens, i);
+				tokens.clear();
+				line = eol + 1;
+			}
+			if (line > end) line = end;
+			// Let the next stage of a pipeline see what we have so
+			// far before possibly blocking on more input
+			out.flush();
+			// Keep the partial line for the next block
+			filled = end - line;
+			memmove(&buffer[0], line, filled);
 		}
-		return ret;
 	}
 }
 
+// The N of -j N, a non-negative integer; 0 means one thread per core
+static unsigned jobCount(const char *arg) {
+	char *end;
+	errno = 0;
+	unsigned long n = strtoul(arg, &end, 10);
+	if (*arg < '0' || *arg > '9' || *end != '\0' || errno == ERANGE || n > UINT_MAX)
+		throw string("ERROR: -j takes a non-negative integer, not ") + arg;
+	if (n == 0) return std::max(1u, std::thread::hardware_concurrency());
+	return n;
+}
+
 int main(int argc, char* argv[]) {
-	// Nested vector representing lines of Tokens
-	// Needs to be used here to cleanup in the case
-	// of an exception
-	vector< vector<Token*> > tokLines;
 	try {
+		// -s streams Tokens out as each line is scanned instead of
+		// scanning the whole input first. Nothing else changes, except
+		// that on an error the Tokens of the lines before it have
+		// already been printed.
+		// -j N scans the input with N threads (0 for one per core);
+		// it has no effect together with -s.
+		// -b writes the binary token format of wlp4binary.h, which
+		// wlp4parse recognizes by its magic number.
+		bool streaming = false;
+		bool binary = false;
+		unsigned jobs = 1;
+		const char *fileName = nullptr;
+		for (int i = 1; i < argc; ++i) {
+			string arg = argv[i];
+			if (arg == "-s") streaming = true;
+			else if (arg == "-b") binary = true;
+			else if (arg == "-j") {
+				if (i + 1 == argc) throw string("ERROR: -j takes a number of threads");
+				jobs = jobCount(argv[++i]);
+			}
+			else if (arg[0] == '-') throw "ERROR: unknown option " + arg;
+			else if (fileName) throw string("ERROR: more than one input file");
+			else fileName = argv[i];
+		}
 		// Create a MIPS recognizer to tokenize
 		// the input lines
 		Lexer lexer;
-		// Tokenize each line of the input
-		string line;
-		while (getline(cin, line)) {
-			tokLines.push_back(lexer.scan(line));
+		Output out;
+		TokenPrinter print = binary ? writeToken : printToken;
+		if (streaming) {
+			if (binary) out.put(WLP4::tokenMagic, sizeof WLP4::tokenMagic);
+			int fd = STDIN_FILENO;
+			if (fileName && (fd = open(fileName, O_RDONLY)) < 0)
+				throw string("ERROR: cannot open ") + fileName;
+			streamSource(lexer, fd, out, print);
+			if (fd != STDIN_FILENO) close(fd);
+			return 0;
 		}
+		// With a file argument the source is memory-mapped, otherwise
+		// all of standard input is read in
+		std::unique_ptr<Source> source(fileName ? new Source(fileName) : new Source());
+		// Tokenize each line of the input
+		TokenStream tokens;
+		scanParallel(lexer, *source, tokens, jobs);
 
-		// Iterate over the lines of tokens and print them
-		// to standard error
-		vector<vector<Token*> >::iterator it;
-		for (it = tokLines.begin(); it != tokLines.end(); ++it) {
-			vector<Token*>::iterator it2;
-			for (it2 = it->begin(); it2 != it->end(); ++it2) {
-				std::cout << *(*it2) << endl;
-			}
+		// Iterate over the tokens and print them
+		// to standard output
+		if (binary) out.put(WLP4::tokenMagic, sizeof WLP4::tokenMagic);
+		for (size_t i = 0; i < tokens.size(); ++i) {
+			print(out, source->begin(), tokens, i);
 		}
 	}
 	catch (const string& msg) {
 		// If an exception occurs print the message and end the program
 		std::cerr << msg << endl;
 	}
-	// Delete the Tokens that have been made
-	vector<vector<Token*> >::iterator it;
-	for (it = tokLines.begin(); it != tokLines.end(); ++it) {
-		vector<Token*>::iterator it2;
-		for (it2 = it->begin(); it2 != it->end(); ++it2) {
-			delete *it2;
-		}
-	}
 }
-
-
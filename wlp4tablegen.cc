@@ -0,0 +1,275 @@
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <map>
+#include <iostream>
+#include <string>
+#include <cstdint>
+#include "wlp4grammar.h"
+using namespace std;
+
+// Builds the LALR(1) automaton of the grammar in wlp4grammar.h and
+// prints it as the tables wlp4parse runs on:
+//	wlp4tablegen > wlp4tables.h
+// Rerun it whenever the grammar changes.
+
+// A set of terminals, one bit each
+typedef uint64_t Lookaheads;
+static_assert(WLP4::NUM_TERMINALS <= 64, "too many terminals for a lookahead set");
+
+// Which symbols derive the empty string, and the terminals that can
+// start a string derived from each symbol
+bool nullable[WLP4::NUM_SYMBOLS];
+Lookaheads first[WLP4::NUM_SYMBOLS];
+
+void analyzeGrammar() {
+	for (int t = 0; t < WLP4::NUM_TERMINALS; t++) {
+		first[t] = Lookaheads(1) << t;
+	}
+	for (bool changed = true; changed; ) {
+		changed = false;
+		for (const WLP4::Rule &rule : WLP4::rules) {
+			Lookaheads starts = first[rule.lhs];
+			bool empty = true;
+			for (int i = 0; i < rule.length && empty; i++) {
+				starts |= first[rule.rhs[i]];
+				empty = nullable[rule.rhs[i]];
+			}
+			if (starts != first[rule.lhs] || (empty && !nullable[rule.lhs])) {
+				first[rule.lhs] = starts;
+				nullable[rule.lhs] = nullable[rule.lhs] || empty;
+				changed = true;
+			}
+		}
+	}
+}
+
+// An item: rule with the dot before rhs[dot], and its lookaheads
+struct Item {
+	int rule;
+	int dot;
+	Lookaheads lookaheads;
+};
+
+// The items of a state without their lookaheads, which is what LALR(1)
+// tells states apart by
+typedef vector<pair<int, int>> Core;
+
+Core coreOf(const vector<Item> &items) {
+	Core core;
+	for (const Item &item : items) {
+		core.emplace_back(item.rule, item.dot);
+	}
+	return core;
+}
+
+// Adds the items the kernel implies, each with the lookaheads of every
+// way it arises
+vector<Item> closure(const vector<Item> &kernel) {
+	vector<Item> items(kernel);
+	map<pair<int, int>, size_t> index;
+	for (size_t i = 0; i < items.size(); i++) {
+		index[make_pair(items[i].rule, items[i].dot)] = i;
+	}
+	deque<size_t> pending;
+	for (size_t i = 0; i < items.size(); i++) pending.push_back(i);
+	while (!pending.empty()) {
+		Item item = items[pending.front()];
+		pending.pop_front();
+		const WLP4::Rule &rule = WLP4::rules[item.rule];
+		if (item.dot == rule.length || rule.rhs[item.dot] < WLP4::NUM_TERMINALS) continue;
+		// What may follow the nonterminal after the dot
+		Lookaheads follow = 0;
+		bool empty = true;
+		for (int i = item.dot + 1; i < rule.length && empty; i++) {
+			follow |= first[rule.rhs[i]];
+			empty = nullable[rule.rhs[i]];
+		}
+		if (empty) follow |= item.lookaheads;
+		for (int r = 0; r < WLP4::NUM_RULES; r++) {
+			if (WLP4::rules[r].lhs != rule.rhs[item.dot]) continue;
+			auto found = index.find(make_pair(r, 0));
+			if (found == index.end()) {
+				index[make_pair(r, 0)] = items.size();
+				pending.push_back(items.size());
+				items.push_back(Item{ r, 0, follow });
+			}
+			else if ((items[found->second].lookaheads | follow) != items[found->second].lookaheads) {
+				items[found->second].lookaheads |= follow;
+				pending.push_back(found->second);
+			}
+		}
+	}
+	return items;
+}
+
+struct State {
+	// Sorted by rule and dot
+	vector<Item> kernel;
+	// The state reached on each symbol, or -1
+	int next[WLP4::NUM_SYMBOLS];
+};
+
+// The LR(1) automaton with states of the same core merged as they are
+// found: a new lookahead reaching an existing state sends it round
+// again, until no lookahead set grows
+vector<State> buildStates() {
+	vector<State> states(1);
+	states[0].kernel.push_back(Item{ 0, 0, 0 });
+	map<Core, int> byCore;
+	byCore[coreOf(states[0].kernel)] = 0;
+	deque<int> pending(1, 0);
+	vector<bool> queued(1, true);
+	while (!pending.empty()) {
+		int s = pending.front();
+		pending.pop_front();
+		queued[s] = false;
+		vector<Item> items = closure(states[s].kernel);
+		map<int, vector<Item>> kernels;
+		for (const Item &item : items) {
+			const WLP4::Rule &rule = WLP4::rules[item.rule];
+			if (item.dot < rule.length) {
+				kernels[rule.rhs[item.dot]].push_back(Item{ item.rule, item.dot + 1, item.lookaheads });
+			}
+		}
+		for (int symbol = 0; symbol < WLP4::NUM_SYMBOLS; symbol++) {
+			states[s].next[symbol] = -1;
+		}
+		for (auto &entry : kernels) {
+			vector<Item> &kernel = entry.second;
+			sort(kernel.begin(), kernel.end(), [](const Item &a, const Item &b) {
+				return make_pair(a.rule, a.dot) < make_pair(b.rule, b.dot);
+			});
+			Core core = coreOf(kernel);
+			auto found = byCore.find(core);
+			int target;
+			bool grew = false;
+			if (found == byCore.end()) {
+				target = states.size();
+				byCore[core] = target;
+				states.push_back(State{ kernel, {} });
+				queued.push_back(false);
+				grew = true;
+			}
+			else {
+				target = found->second;
+				for (size_t i = 0; i < kernel.size(); i++) {
+					Lookaheads &lookaheads = states[target].kernel[i].lookaheads;
+					grew = grew || (lookaheads | kernel[i].lookaheads) != lookaheads;
+					lookaheads |= kernel[i].lookaheads;
+				}
+			}
+			if (grew && !queued[target]) {
+				queued[target] = true;
+				pending.push_back(target);
+			}
+			states[s].next[entry.first] = target;
+		}
+	}
+	return states;
+}
+
+// The action table, encoded as in wlp4tables.h. Rule 0 is never
+// reduced: the parser accepts once it has shifted the EOF at its end.
+vector<vector<int>> buildActions(const vector<State> &states) {
+	vector<vector<int>> action(states.size(), vector<int>(WLP4::NUM_SYMBOLS));
+	for (size_t s = 0; s < states.size(); s++) {
+		for (int symbol = 0; symbol < WLP4::NUM_SYMBOLS; symbol++) {
+			if (states[s].next[symbol] >= 0) action[s][symbol] = states[s].next[symbol] + 1;
+		}
+		for (const Item &item : closure(states[s].kernel)) {
+			if (item.rule == 0 || item.dot != WLP4::rules[item.rule].length) continue;
+			for (int t = 0; t < WLP4::NUM_TERMINALS; t++) {
+				if (!(item.lookaheads >> t & 1)) continue;
+				if (action[s][t] != 0) {
+					throw string("ERROR: conflict on ") + WLP4::symbolNames[t] + " between rule " +
+						to_string(item.rule) + " and " + (action[s][t] > 0 ? string("a shift") : "rule " + to_string(-action[s][t] - 1));
+				}
+				action[s][t] = -item.rule - 1;
+			}
+		}
+	}
+	return action;
+}
+
+// Merges states that act alike, by Moore's partition refinement: two
+// states stay together while they reduce by the same rules on the same
+// lookaheads and every transition leads to states that stay together.
+// The states that are left are numbered breadth first from the start
+// state, which keeps number 0.
+vector<vector<int>> minimize(const vector<vector<int>> &action) {
+	size_t n = action.size();
+	vector<int> block(n, 0);
+	for (size_t blocks = 1; ; ) {
+		map<vector<int>, int> signatures;
+		vector<int> refined(n);
+		for (size_t s = 0; s < n; s++) {
+			vector<int> signature(1, block[s]);
+			for (int act : action[s]) {
+				signature.push_back(act > 0 ? block[act - 1] + 1 : act);
+			}
+			auto found = signatures.emplace(signature, signatures.size());
+			refined[s] = found.first->second;
+		}
+		block.swap(refined);
+		if (signatures.size() == blocks) break;
+		blocks = signatures.size();
+	}
+
+	vector<int> number(n, -1);
+	vector<int> order;
+	number[block[0]] = 0;
+	order.push_back(0);
+	for (size_t i = 0; i < order.size(); i++) {
+		for (int act : action[order[i]]) {
+			if (act <= 0 || number[block[act - 1]] >= 0) continue;
+			number[block[act - 1]] = order.size();
+			order.push_back(act - 1);
+		}
+	}
+	vector<vector<int>> minimal;
+	for (int s : order) {
+		minimal.push_back(action[s]);
+		for (int &act : minimal.back()) {
+			if (act > 0) act = number[block[act - 1]] + 1;
+		}
+	}
+	return minimal;
+}
+
+void printTables(const vector<vector<int>> &action) {
+	cout << "#ifndef __WLP4TABLES_H__\n"
+		"#define __WLP4TABLES_H__\n"
+		"#include <cstdint>\n"
+		"#include \"wlp4grammar.h\"\n"
+		"\n"
+		"// Generated by wlp4tablegen from wlp4grammar.h; do not edit.\n"
+		"namespace WLP4 {\n"
+		"\t// The LALR(1) automaton as a dense table indexed by state and\n"
+		"\t// symbol id: 0 is an error, v > 0 shifts to (or, on a nonterminal,\n"
+		"\t// goes to) state v - 1 and v < 0 reduces by rule -v - 1. State 0\n"
+		"\t// is the start state.\n"
+		"\tconst int NUM_STATES = " << action.size() << ";\n"
+		"\tconstexpr int16_t action[NUM_STATES][NUM_SYMBOLS] = {\n";
+	for (size_t s = 0; s < action.size(); s++) {
+		cout << "\t\t{";
+		for (int symbol = 0; symbol < WLP4::NUM_SYMBOLS; symbol++) {
+			cout << (symbol ? ", " : " ") << action[s][symbol];
+		}
+		cout << " },\n";
+	}
+	cout << "\t};\n"
+		"}\n"
+		"#endif\n";
+}
+
+int main() {
+	try {
+		analyzeGrammar();
+		printTables(minimize(buildActions(buildStates())));
+	}
+	catch (const string &msg) {
+		cerr << msg << endl;
+		return 1;
+	}
+}